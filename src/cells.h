@@ -0,0 +1,104 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "raylib.h"
+
+#ifndef CELLS_H_
+#define CELLS_H_
+
+// Most cells in any layout, cell ids have to fit 'int16_t'
+#define CELLS_MAX	16384
+
+// *
+// Placement of a uniform cell grid in world space, shared by the spatial grid,
+// fog of war, static layer and their render side copies
+//
+// Cell (0, 0) starts at 'origin', positions before it fall in negative cells.
+// *
+typedef struct {
+	Vector2 origin;
+	Vector2 cell_size;
+
+	uint16_t cols;
+	uint16_t rows;
+
+} CellLayout;
+
+// Column or row of world coordinate, not clamped
+static inline float CellCol(const CellLayout *layout, float x) {
+	return floorf((x - layout->origin.x) / layout->cell_size.x);
+}
+
+static inline float CellRow(const CellLayout *layout, float y) {
+	return floorf((y - layout->origin.y) / layout->cell_size.y);
+}
+
+static inline bool CellInLayout(const CellLayout *layout, int32_t c, int32_t r) {
+	return c >= 0 && r >= 0 && c < layout->cols && r < layout->rows;
+}
+
+// Cell id of position, -1 outside layout
+static inline int32_t CellOf(const CellLayout *layout, Vector2 position) {
+	float c = CellCol(layout, position.x);
+	float r = CellRow(layout, position.y);
+
+	if(c < 0 || r < 0 || c >= layout->cols || r >= layout->rows) return -1;
+
+	return (int32_t)c + (int32_t)r * layout->cols;
+}
+
+// Cells overlapping world rectangle, clamped to layout
+static inline void CellRange(const CellLayout *layout, Rectangle rec, int16_t *col_start, int16_t *row_start, int16_t *col_end, int16_t *row_end) {
+	*col_start = fminf(fmaxf(CellCol(layout, rec.x), 0), layout->cols - 1);
+	*row_start = fminf(fmaxf(CellRow(layout, rec.y), 0), layout->rows - 1);
+	*col_end = fminf(fmaxf(CellCol(layout, rec.x + rec.width), 0), layout->cols - 1);
+	*row_end = fminf(fmaxf(CellRow(layout, rec.y + rec.height), 0), layout->rows - 1);
+}
+
+// World position of cell's top left corner
+static inline Vector2 CellCorner(const CellLayout *layout, int32_t c, int32_t r) {
+	return (Vector2) {
+		.x = layout->origin.x + c * layout->cell_size.x,
+		.y = layout->origin.y + r * layout->cell_size.y
+	};
+}
+
+// World area covered by layout
+static inline Rectangle CellLayoutBounds(const CellLayout *layout) {
+	return (Rectangle) {
+		.x = layout->origin.x,
+		.y = layout->origin.y,
+		.width = layout->cols * layout->cell_size.x,
+		.height = layout->rows * layout->cell_size.y
+	};
+}
+
+static inline bool CellLayoutEqual(const CellLayout *a, const CellLayout *b) {
+	return a->cols == b->cols && a->rows == b->rows &&
+		a->origin.x == b->origin.x && a->origin.y == b->origin.y &&
+		a->cell_size.x == b->cell_size.x && a->cell_size.y == b->cell_size.y;
+}
+
+// Square cells covering 'bounds', grown past 'cell_size' if the cell count would exceed 'CELLS_MAX'
+static inline CellLayout CellLayoutFit(Rectangle bounds, float cell_size) {
+	float size = fmaxf(cell_size, sqrtf(bounds.width * bounds.height / CELLS_MAX));
+
+	// Rounding up can add a row and column, grow until it fits
+	for(;;) {
+		float cols = fmaxf(ceilf(bounds.width / size), 1);
+		float rows = fmaxf(ceilf(bounds.height / size), 1);
+
+		if(cols * rows <= CELLS_MAX) {
+			return (CellLayout) {
+				.origin = (Vector2) { bounds.x, bounds.y },
+				.cell_size = (Vector2) { size, size },
+				.cols = cols,
+				.rows = rows
+			};
+		}
+
+		size *= 1.05f;
+	}
+}
+
+#endif
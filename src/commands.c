@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <stdio.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "commands.h"
+#include "handler.h"
+#include "prefabs.h"
+
+// Initial buffer capacities
+#define CMD_BUFFER_CAP		64
+#define CMD_UNIT_BUFFER_CAP	1024
+
+void CommandBufferInit(CommandBuffer *buf) {
+	vec_cmd_init(&buf->commands, CMD_BUFFER_CAP);
+	vec_ent_init(&buf->units, CMD_UNIT_BUFFER_CAP);
+}
+
+void CommandBufferClose(CommandBuffer *buf) {
+	vec_cmd_free(&buf->commands);
+	vec_ent_free(&buf->units);
+}
+
+void CommandBufferClear(CommandBuffer *buf) {
+	vec_cmd_clear(&buf->commands);
+	vec_ent_clear(&buf->units);
+}
+
+void CommandPush(CommandBuffer *buf, Order order, INT_N *units, uint32_t unit_count, uint8_t flags) {
+	if(!unit_count) return;
+
+	Command cmd = (Command) {
+		.order = order,
+		.unit_start = buf->units.count,
+		.unit_count = unit_count,
+		.flags = flags
+	};
+
+	vec_ent_append(&buf->units, units, unit_count);
+	vec_cmd_push(&buf->commands, cmd);
+}
+
+void CommandPushBuild(CommandBuffer *buf, uint8_t prefab, Vector2 position) {
+	Command cmd = (Command) {
+		.order = (Order) { .target = position, .type = prefab },
+		.unit_start = buf->units.count,
+		.flags = CMD_BUILD
+	};
+
+	vec_cmd_push(&buf->commands, cmd);
+}
+
+void CommandsExecute(CommandBuffer *buf, Handler *handler) {
+	for(size_t i = 0; i < buf->commands.count; i++) {
+		Command *cmd = &buf->commands.data[i];
+		INT_N *units = &buf->units.data[cmd->unit_start];
+
+		// Placement fails quietly if pools are full
+		if(cmd->flags & CMD_BUILD) {
+			if(cmd->order.type < prefab_count && PrefabBuildable(&prefabs[cmd->order.type])) 
+				SpawnPrefab(handler, &prefabs[cmd->order.type], cmd->order.target);
+
+			continue;
+		}
+
+		// Apply order to every unit in the group
+		for(uint32_t j = 0; j < cmd->unit_count; j++) {
+			Entity *entity = &handler->entities[units[j]];
+			if(!(entity->components & COMP_ORDERS)) continue;
+
+			INT_N orders_id = entity->comp_map.component_id[comp_index(COMP_ORDERS)];
+			Order order = cmd->order;
+
+			// Replace queue unless queueing
+			if(!(cmd->flags & CMD_QUEUE)) OrdersClear(handler, orders_id);
+
+			// Patrol starts from wherever the unit will be when the order begins
+			if(order.type == ORDER_PATROL) {
+				Order *back = OrdersBack(handler, orders_id);
+				comp_Transform *transform = HandlerGetComponent(handler, units[j], COMP_TRANSFORM);
+
+				if(back && back->type != ORDER_HOLD) order.origin = back->target;
+				else if(transform) order.origin = transform->position;
+			}
+
+			// Full queues drop the order
+			OrdersPush(handler, orders_id, order);
+		}
+	}
+
+	CommandBufferClear(buf);
+}
@@ -0,0 +1,53 @@
+#include <stdint.h>
+#include "raylib.h"
+#include "handler.h"
+#include "vec.h"
+
+#ifndef COMMANDS_H_
+#define COMMANDS_H_
+
+// Command flags
+// Append order to unit queues instead of replacing them
+#define CMD_QUEUE	0x01
+
+// Spawn prefab 'order.type' at 'order.target', no units involved
+#define CMD_BUILD	0x02
+
+// A single order given to a group of units
+// Unit ids are stored contiguously in the buffer's 'units' array
+typedef struct {
+	Order order;
+
+	uint32_t unit_start;
+	uint32_t unit_count;
+
+	uint8_t flags;
+
+} Command;
+
+vec_declare(vec_cmd, Command)
+
+// Commands issued since last execution
+// Memory is kept between frames, no allocations once warmed up
+typedef struct {
+	vec_cmd commands;
+	vec_ent units;
+
+} CommandBuffer;
+
+void CommandBufferInit(CommandBuffer *buf);
+void CommandBufferClose(CommandBuffer *buf);
+
+// Drop all recorded commands
+void CommandBufferClear(CommandBuffer *buf);
+
+// Record an order for a group of units
+void CommandPush(CommandBuffer *buf, Order order, INT_N *units, uint32_t unit_count, uint8_t flags);
+
+// Record placing a prefab
+void CommandPushBuild(CommandBuffer *buf, uint8_t prefab, Vector2 position);
+
+// Apply all recorded commands to unit order queues, then clear buffer
+void CommandsExecute(CommandBuffer *buf, Handler *handler);
+
+#endif
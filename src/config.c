@@ -1,146 +1,410 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <math.h>
 
 #include "raylib.h"
 #include "raymath.h"
 
 #include "config.h"
 
-// Read configuration options from provided file
-void ConfigRead(Config *conf, char *path) {
-	// Open file
-	FILE *pF = fopen(path, "r");
+#if TARGET_PLATFORM == PLATFORM_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
-	// Clear debug flags
-	conf->debug_flags = 0;
+// Longest line in options file, longer ones are rejected
+#define CONFIG_LINE_MAX	256
+
+// Lookup table slots, power of two, over twice the option count
+#define CONFIG_HASH_SIZE 64
+
+#define conf_field(_field) .offset = offsetof(Config, _field), .size = sizeof(((Config*)0)->_field)
+
+static float AutoWindowWidth(void) { return GetMonitorWidth(0); }
+static float AutoWindowHeight(void) { return GetMonitorHeight(0); }
+static float AutoRefreshRate(void) { return GetMonitorRefreshRate(0); }
+
+ConfigOption config_options[] = {
+	{ .name = "window_width",	.type = CONF_UINT, conf_field(window_width),	.min = 320, .max = 7680, .def = CONFIG_DEFAULT_WW, .auto_value = AutoWindowWidth },
+	{ .name = "window_height",	.type = CONF_UINT, conf_field(window_height),	.min = 240, .max = 4320, .def = CONFIG_DEFAULT_WH, .auto_value = AutoWindowHeight },
+	{ .name = "refresh_rate",	.type = CONF_FLOAT, .flags = CONF_LIVE, conf_field(refresh_rate), .min = 10, .max = 500, .def = CONFIG_DEFAULT_RR, .auto_value = AutoRefreshRate },
+
+	// Simulation
+	{ .name = "tick_rate",		.type = CONF_UINT, .flags = CONF_LIVE, conf_field(tick_rate), .min = 10, .max = 240, .def = CONFIG_DEFAULT_TR },
+	{ .name = "sim_thread",		.type = CONF_BOOL, conf_field(sim_thread), .def = 1 },
+	{ .name = "cell_ent_cap",	.type = CONF_UINT, .flags = CONF_LIVE, conf_field(cell_ent_cap), .min = 1, .max = 255, .def = CONFIG_DEFAULT_CELL_CAP },
+	{ .name = "grid_cell_size",	.type = CONF_FLOAT, .flags = CONF_LIVE, conf_field(grid_cell_size), .min = 16, .max = 4096, .def = CONFIG_DEFAULT_CELL_SIZE },
+	{ .name = "grid_offset_x",	.type = CONF_FLOAT, conf_field(grid_offset_x), .min = -1e6f, .max = 1e6f, .def = 0 },
+	{ .name = "grid_offset_y",	.type = CONF_FLOAT, conf_field(grid_offset_y), .min = -1e6f, .max = 1e6f, .def = 0 },
+	{ .name = "grid_auto_tune",	.type = CONF_BOOL, conf_field(grid_auto_tune), .def = 0 },
+	{ .name = "level_path",		.type = CONF_STRING, conf_field(level_path), .def_string = CONFIG_DEFAULT_LEVEL },
+
+	// Rendering
+	{ .name = "particle_budget",	.type = CONF_UINT, .flags = CONF_LIVE, conf_field(particle_budget), .min = 256, .max = 1 << 20, .def = CONFIG_DEFAULT_PB },
+	{ .name = "dynamic_resolution",	.type = CONF_BOOL, conf_field(dynamic_resolution), .def = 0 },
+	{ .name = "resolution_min",		.type = CONF_FLOAT, .flags = CONF_LIVE, conf_field(resolution_min), .min = 0.25f, .max = 2.0f, .def = CONFIG_DEFAULT_RMIN },
+	{ .name = "resolution_max",		.type = CONF_FLOAT, conf_field(resolution_max), .min = 0.25f, .max = 2.0f, .def = CONFIG_DEFAULT_RMAX },
+	{ .name = "lod_mid_zoom",		.type = CONF_FLOAT, .flags = CONF_LIVE, conf_field(lod_mid_zoom), .min = 0.01f, .max = 10.0f, .def = CONFIG_DEFAULT_LOD_MID },
+	{ .name = "lod_far_zoom",		.type = CONF_FLOAT, .flags = CONF_LIVE, conf_field(lod_far_zoom), .min = 0.01f, .max = 10.0f, .def = CONFIG_DEFAULT_LOD_FAR },
+
+	// Debug
+	{ .name = "debug_show_grid",		.type = CONF_FLAG, .flags = CONF_LIVE, conf_field(debug_flags), .bit = SHOW_GRID },
+	{ .name = "debug_show_colliders",	.type = CONF_FLAG, .flags = CONF_LIVE, conf_field(debug_flags), .bit = SHOW_COLLIDERS },
+	{ .name = "debug_show_profiler",	.type = CONF_FLAG, .flags = CONF_LIVE, conf_field(debug_flags), .bit = SHOW_PROFILER }
+};
+
+#define CONFIG_OPTION_COUNT (sizeof(config_options) / sizeof(config_options[0]))
+
+// Option index + 1 per slot, 0 if empty, filled on first lookup
+uint8_t config_lookup[CONFIG_HASH_SIZE] = { 0 };
+bool config_lookup_built = false;
+
+// FNV-1a
+static uint32_t ConfigHash(const char *key) {
+	uint32_t hash = 2166136261u;
+
+	for(; *key; key++) {
+		hash ^= (uint8_t)*key;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static void ConfigBuildLookup() {
+	for(uint8_t i = 0; i < CONFIG_OPTION_COUNT; i++) {
+		uint32_t slot = ConfigHash(config_options[i].name) & (CONFIG_HASH_SIZE - 1);
+
+		while(config_lookup[slot]) slot = (slot + 1) & (CONFIG_HASH_SIZE - 1);
+		config_lookup[slot] = i + 1;
+	}
+
+	config_lookup_built = true;
+}
+
+const ConfigOption *ConfigFind(const char *key) {
+	if(!config_lookup_built) ConfigBuildLookup();
+
+	for(uint32_t slot = ConfigHash(key) & (CONFIG_HASH_SIZE - 1); config_lookup[slot]; slot = (slot + 1) & (CONFIG_HASH_SIZE - 1)) {
+		const ConfigOption *option = &config_options[config_lookup[slot] - 1];
+		if(streq(option->name, key)) return option;
+	}
+
+	return NULL;
+}
+
+// Strip whitespace and line end from both sides, in place
+static char *ConfigTrim(char *str) {
+	while(isspace((unsigned char)*str)) str++;
+
+	char *end = str + strlen(str);
+	while(end > str && isspace((unsigned char)end[-1])) end--;
+	*end = '\0';
+
+	return str;
+}
+
+static void ConfigStoreUint(void *field, size_t size, unsigned long value) {
+	switch(size) {
+		case 1: *(uint8_t*)field = value;	break;
+		case 2: *(uint16_t*)field = value;	break;
+		case 4: *(uint32_t*)field = value;	break;
+	}
+}
+
+static void ConfigSetOptionDefault(Config *conf, const ConfigOption *option) {
+	void *field = (uint8_t*)conf + option->offset;
+
+	switch(option->type) {
+		case CONF_UINT:		ConfigStoreUint(field, option->size, option->def);		break;
+		case CONF_FLOAT:	*(float*)field = option->def;							break;
+		case CONF_BOOL:		*(uint8_t*)field = (option->def != 0);					break;
+		case CONF_FLAG:		*(uint8_t*)field &= ~option->bit;						break;
+
+		case CONF_STRING:
+			snprintf(field, option->size, "%s", (option->def_string) ? option->def_string : "");
+			break;
+	}
+}
+
+// Number inside option range, out of range values are clamped with a warning
+static bool ConfigParseNumber(const ConfigOption *option, const char *val, float *out) {
+	char *end;
+	float value = strtof(val, &end);
+
+	if(end == val || *end) {
+		printf("WARNING: Config %s: '%s' is not a number\n", option->name, val);
+		return false;
+	}
+
+	if(option->type == CONF_UINT && value != floorf(value)) {
+		printf("WARNING: Config %s: '%s' is not a whole number\n", option->name, val);
+		return false;
+	}
+
+	if(value < option->min || value > option->max) {
+		printf("WARNING: Config %s: %g outside [%g, %g], clamped\n", option->name, value, option->min, option->max);
+		value = Clamp(value, option->min, option->max);
+	}
+
+	*out = value;
+	return true;
+}
+
+static void ConfigApply(Config *conf, const ConfigOption *option, const char *val) {
+	void *field = (uint8_t*)conf + option->offset;
+
+	// Auto: ask the platform, or fall back to the default
+	if(streq(val, AUTO) && option->type != CONF_STRING) {
+		if(!option->auto_value) {
+			ConfigSetOptionDefault(conf, option);
+			return;
+		}
+
+		float value = option->auto_value();
+
+		if(option->type == CONF_UINT) ConfigStoreUint(field, option->size, value);
+		else if(option->type == CONF_FLOAT) *(float*)field = value;
 
-	// Early out and error log if file path invalid
-	if(!pF) {
-		printf("ERROR: Could not open configuration file at: %s\n", path);	
-		ConfigSetDefault(conf);
 		return;
 	}
 
-	puts("Reading configuration file...");
-	
+	switch(option->type) {
+		case CONF_UINT: {
+			float value;
+			if(ConfigParseNumber(option, val, &value)) ConfigStoreUint(field, option->size, value);
+		} break;
+
+		case CONF_FLOAT: {
+			float value;
+			if(ConfigParseNumber(option, val, &value)) *(float*)field = value;
+		} break;
+
+		case CONF_BOOL:
+		case CONF_FLAG: {
+			bool on = streq(val, "true");
+
+			if(!on && !streq(val, "false")) {
+				printf("WARNING: Config %s: expected true or false, got '%s'\n", option->name, val);
+				return;
+			}
+
+			if(option->type == CONF_BOOL) *(uint8_t*)field = on;
+			else if(on) *(uint8_t*)field |= option->bit;
+			else *(uint8_t*)field &= ~option->bit;
+		} break;
+
+		case CONF_STRING: {
+			if(streq(val, AUTO)) {
+				ConfigSetOptionDefault(conf, option);
+				return;
+			}
+
+			if(strlen(val) >= option->size) {
+				printf("WARNING: Config %s: longer than %d characters, ignored\n", option->name, (int)option->size - 1);
+				return;
+			}
+
+			memcpy(field, val, strlen(val) + 1);
+		} break;
+	}
+}
+
+// Parse whole file into 'conf', false if it can't be opened
+static bool ConfigReadFile(Config *conf, char *path) {
+	FILE *pF = fopen(path, "r");
+	if(!pF) return false;
+
 	// Parse config file line by line
-	char line[128];
-	while(fgets(line, sizeof(line), pF)) 
-		ConfigParseLine(conf, line);		
-	
-	// Close file, print debug messages
+	char line[CONFIG_LINE_MAX];
+	uint32_t line_number = 0;
+
+	while(fgets(line, sizeof(line), pF)) {
+		line_number++;
+
+		// Line didn't fit, skip the rest of it
+		if(!strchr(line, '\n') && !feof(pF)) {
+			printf("WARNING: Config line %d is too long, ignored\n", line_number);
+
+			int c;
+			while((c = fgetc(pF)) != '\n' && c != EOF);
+			continue;
+		}
+
+		ConfigParseLine(conf, line);
+	}
+
 	fclose(pF);
+	return true;
+}
+
+// Read configuration options from provided file
+void ConfigRead(Config *conf, char *path) {
+	// Options missing from file keep their defaults
+	ConfigSetDefault(conf);
+
+	puts("Reading configuration file...");
+
+	// Early out and error log if file path invalid
+	if(!ConfigReadFile(conf, path))
+		printf("ERROR: Could not open configuration file at: %s\n", path);
+
 	ConfigPrintValues(conf);
 }
 
 // Parse an individual line from config file
 void ConfigParseLine(Config *conf, char *line) {
-	// Ignore commented lines
-	if(line[0] == '#') return;
-	
+	line = ConfigTrim(line);
+
+	// Ignore empty and commented lines
+	if(line[0] == '#' || line[0] == '\0') return;
+
 	// Split value and option key
-	char *eq = strchr(line, '='); 
-	if(!eq) return;	
+	char *eq = strchr(line, '=');
+	if(!eq) return;
 
 	*eq = '\0';
-	char *key = line;
-	char *val = eq + 1;
-
-	if(streq(key, "window_width")) {
-		// Window width:    
-		// if auto option provided, set from monitor resolution
-		if(streq(val, AUTO)) 
-			conf->window_width = GetMonitorWidth(0);
-		else 
-			sscanf(val, "%d", &conf->window_width);
-
-	} else if(streq(key, "window_height")) {
-		// Window height:    
-		// if auto option provided, set from monitor resolution
-		if(streq(val, AUTO)) 
-			conf->window_height = GetMonitorHeight(0);
-		else
-			sscanf(val, "%d", &conf->window_height);
-		
-	} else if(streq(key, "refresh_rate")) {
-		// Refresh rate:
-		// if auto option provided, set from monitor refresh rate
-		if(streq(val, AUTO)) 
-			conf->refresh_rate = GetMonitorRefreshRate(0);
-		else 
-			sscanf(val, "%f", &conf->refresh_rate);
-
-	} else if(streq(key, "level_path")) {
-		// Level Path:
-		// for testing purposes
-		if(streq(val, AUTO)) {
-			char default_path[64] = "level.lvl";
-			memcpy(default_path, val, sizeof(default_path));
-
-			char *n = strchr(default_path, '\n');
-			*n = '\0';
-
-			memcpy(conf->level_path, default_path, sizeof(default_path));
-			
-		} else {
-			char custom_path[64];
-			memcpy(custom_path, val, sizeof(custom_path));
-			
-			char *n = strchr(custom_path, '\n');
-			*n = '\0';
-
-			memcpy(conf->level_path, custom_path, sizeof(custom_path));
-		}
+	char *key = ConfigTrim(line);
+	char *val = ConfigTrim(eq + 1);
 
-	} else if(streq(key, "debug_show_grid")) {
+	const ConfigOption *option = ConfigFind(key);
 
-		char *n = strchr(val, '\n');
-		if(n) *n = '\0';
+	if(!option) {
+		printf("WARNING: Unknown config option '%s'\n", key);
+		return;
+	}
 
-		if(streq(val, "true"))
-			conf->debug_flags |= SHOW_GRID;
+	ConfigApply(conf, option, val);
+}
 
-		bool on = (conf->debug_flags & SHOW_GRID);
-		printf("debug option, show grid set to: %s\n", (on) ? "true" : "false");
-		
-	} else if(streq(key, "debug_show_colliders")) {
+// Set default config options
+void ConfigSetDefault(Config *conf) {
+	*conf = (Config) { 0 };
 
-		char *n = strchr(val, '\n');
-		if(n) *n = '\0';
+	for(uint8_t i = 0; i < CONFIG_OPTION_COUNT; i++)
+		ConfigSetOptionDefault(conf, &config_options[i]);
+}
 
-		if(streq(val, "true"))
-			conf->debug_flags |= SHOW_COLLIDERS;
+// Print debug messages to shell
+void ConfigPrintValues(Config *conf) {
+	printf("resolution: %dx%d\n", conf->window_width, conf->window_height);
+	printf("refresh rate: %f\n", conf->refresh_rate);
+}
+
+static bool ConfigOptionEqual(const ConfigOption *option, Config *a, Config *b) {
+	const uint8_t *field_a = (uint8_t*)a + option->offset;
+	const uint8_t *field_b = (uint8_t*)b + option->offset;
 
-	} else if(streq(key, "cell_ent_cap")) {
+	if(option->type == CONF_FLAG) return (*field_a & option->bit) == (*field_b & option->bit);
+	if(option->type == CONF_STRING) return streq((const char*)field_a, (const char*)field_b);
 
-		if(streq(val, AUTO)) 
-			conf->cell_ent_cap = 16;
-		else {
-			sscanf(val, "%hhd", &conf->cell_ent_cap);
-			printf("%hhd\n", conf->cell_ent_cap);
+	return memcmp(field_a, field_b, option->size) == 0;
+}
+
+bool ConfigReload(Config *conf, char *path) {
+	// Lines removed from file fall back to defaults
+	Config next;
+	ConfigSetDefault(&next);
+
+	if(!ConfigReadFile(&next, path)) {
+		printf("ERROR: Could not reload configuration file at: %s\n", path);
+		return false;
+	}
+
+	bool changed = false;
+
+	for(uint8_t i = 0; i < CONFIG_OPTION_COUNT; i++) {
+		const ConfigOption *option = &config_options[i];
+		if(ConfigOptionEqual(option, conf, &next)) continue;
+
+		if(!(option->flags & CONF_LIVE)) {
+			printf("Config %s: takes effect after restart\n", option->name);
+			continue;
 		}
-		
-	} 
+
+		uint8_t *dst = (uint8_t*)conf + option->offset;
+		uint8_t *src = (uint8_t*)&next + option->offset;
+
+		if(option->type == CONF_FLAG) *dst = (*dst & ~option->bit) | (*src & option->bit);
+		else memcpy(dst, src, option->size);
+
+		printf("Config %s: reloaded\n", option->name);
+		changed = true;
+	}
+
+	return changed;
 }
 
-// Set default config options 
-void ConfigSetDefault(Config *conf) {
-	*conf = (Config) {
-		.debug_flags = 0,
-		.cell_ent_cap = 16,
-		.grid_offset_x = 0,
-		.grid_offset_y = 0,
-		.window_width  = CONFIG_DEFAULT_WW,
-		.window_height = CONFIG_DEFAULT_WH,
-		.refresh_rate  = CONFIG_DEFAULT_RR
-	};
+bool ConfigWatchInit(ConfigWatch *watch, const char *path) {
+	*watch = (ConfigWatch) { .fd = -1, .wd = -1 };
 
-	ConfigPrintValues(conf);
+#if TARGET_PLATFORM == PLATFORM_LINUX
+	// Editors often save by writing a new file and renaming it over the old one,
+	// which drops a watch on the file itself, so the directory is watched for the name
+	char dir[CONFIG_LINE_MAX] = ".";
+	const char *slash = strrchr(path, '/');
+	const char *name = (slash) ? slash + 1 : path;
+
+	if(slash) snprintf(dir, sizeof(dir), "%.*s", (slash == path) ? 1 : (int)(slash - path), path);
+
+	if(strlen(name) >= sizeof(watch->name)) return false;
+	memcpy(watch->name, name, strlen(name) + 1);
+
+	watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if(watch->fd < 0) {
+		puts("ERROR: Could not start watching config file");
+		return false;
+	}
+
+	watch->wd = inotify_add_watch(watch->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+
+	if(watch->wd < 0) {
+		printf("ERROR: Could not watch config directory: %s\n", dir);
+		ConfigWatchClose(watch);
+		return false;
+	}
+
+	return true;
+#else
+	return false;
+#endif
 }
 
-// Print debug messages to shell
-void ConfigPrintValues(Config *conf) {
-	printf("resolution: %dx%d\n", conf->window_width, conf->window_height);
-	printf("refresh rate: %f\n", conf->refresh_rate);
+void ConfigWatchClose(ConfigWatch *watch) {
+#if TARGET_PLATFORM == PLATFORM_LINUX
+	if(watch->fd >= 0) close(watch->fd);
+#endif
+
+	watch->fd = -1;
+	watch->wd = -1;
 }
 
+bool ConfigWatchPoll(ConfigWatch *watch) {
+	if(watch->fd < 0) return false;
+
+	bool changed = false;
+
+#if TARGET_PLATFORM == PLATFORM_LINUX
+	// Aligned for the event struct, holds many events
+	union {
+		struct inotify_event event;
+		char bytes[4096];
+	} buf;
+
+	ssize_t length;
+
+	while((length = read(watch->fd, buf.bytes, sizeof(buf.bytes))) > 0) {
+		for(char *ptr = buf.bytes; ptr < buf.bytes + length; ) {
+			struct inotify_event *event = (struct inotify_event*)ptr;
+
+			if(event->len && streq(event->name, watch->name)) changed = true;
+			ptr += sizeof(struct inotify_event) + event->len;
+		}
+	}
+#endif
+
+	return changed;
+}
@@ -1,19 +1,45 @@
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 #ifndef CONFIG_H_
 #define CONFIG_H_
 
+// Options file, watched for changes while running
+#define CONFIG_PATH "options.conf"
+
 // Configuration defaults, revert to these values if config file not found
 // Default window width, height and refresh rate
 #define CONFIG_DEFAULT_WW	1920
 #define CONFIG_DEFAULT_WH	1080
 #define CONFIG_DEFAULT_RR	  60
 
+// Default simulation ticks per second
+#define CONFIG_DEFAULT_TR	  60
+
+// Default particle budget
+#define CONFIG_DEFAULT_PB	16384
+
+// Default dynamic resolution bounds, render target pixels per virtual pixel
+#define CONFIG_DEFAULT_RMIN	0.5f
+#define CONFIG_DEFAULT_RMAX	1.0f
+
+// Default zoom thresholds for simplified and aggregated unit drawing
+#define CONFIG_DEFAULT_LOD_MID	0.6f
+#define CONFIG_DEFAULT_LOD_FAR	0.3f
+
+// Default spatial grid cell size and entries per cell
+#define CONFIG_DEFAULT_CELL_SIZE	96
+#define CONFIG_DEFAULT_CELL_CAP		128
+
+#define CONFIG_DEFAULT_LEVEL	"resources/levels/level.lvl"
+
 #define AUTO "auto"
 #define streq(a, b) (strcmp((a), (b)) == 0)
 
 #define SHOW_GRID		0x01
 #define SHOW_COLLIDERS	0x02
+#define SHOW_PROFILER	0x04
 
 #define PLATFORM_LINUX	0
 #define PLATFORM_WIN64	1
@@ -32,15 +58,101 @@ typedef struct {
 
 	float refresh_rate;
 
+	uint16_t tick_rate;
+
+	// Run simulation on its own thread
+	uint8_t sim_thread;
+
+	// Most particles alive at once
+	uint32_t particle_budget;
+
+	// Scale render target to hold refresh rate
+	uint8_t dynamic_resolution;
+	float resolution_min;
+	float resolution_max;
+
+	// Zoom below which units are drawn simplified, then aggregated per cell
+	float lod_mid_zoom;
+	float lod_far_zoom;
+
+	// Spatial grid cell size, grown on levels too large for it
+	float grid_cell_size;
+
+	// Grid origin shift from level bounds
 	float grid_offset_x;
 	float grid_offset_y;
 
+	// Retune grid cell size to how it's queried while playing
+	uint8_t grid_auto_tune;
+
 	char level_path[128];
 } Config;
 
+// Option value types
+enum CONFIG_TYPES {
+	CONF_UINT,		// Unsigned integer field of 1, 2 or 4 bytes
+	CONF_FLOAT,
+	CONF_BOOL,		// 'true' or 'false', stored as 0 or 1
+	CONF_FLAG,		// 'true' or 'false', sets 'bit' in field
+	CONF_STRING		// Char array field
+};
+
+// Option flags
+// Applied on hot reload, others only take effect after a restart
+#define CONF_LIVE	0x01
+
+// *
+// One entry per key in options file
+//
+// Values are validated against [min, max] and clamped with a warning.
+// 'auto' uses 'auto_value' if set, otherwise the default.
+// *
+typedef struct {
+	const char *name;
+
+	uint8_t type;
+	uint8_t flags;
+
+	// Target field in 'Config'
+	size_t offset;
+	size_t size;
+
+	float min;
+	float max;
+
+	float def;
+	const char *def_string;
+	uint8_t bit;
+
+	float (*auto_value)(void);
+
+} ConfigOption;
+
+// Option for key, NULL if there's none
+const ConfigOption *ConfigFind(const char *key);
+
 void ConfigRead(Config *conf, char *path);
 void ConfigParseLine(Config *conf, char *line);
 void ConfigSetDefault(Config *conf);
 void ConfigPrintValues(Config *conf);
 
+// Read file again, copy live options that changed into 'conf', returns true if any did
+bool ConfigReload(Config *conf, char *path);
+
+// Change notifications for options file, inotify on Linux, never fires elsewhere
+typedef struct {
+	int fd;
+	int wd;
+
+	// File name inside watched directory
+	char name[64];
+
+} ConfigWatch;
+
+bool ConfigWatchInit(ConfigWatch *watch, const char *path);
+void ConfigWatchClose(ConfigWatch *watch);
+
+// True if file was written since last poll, never blocks
+bool ConfigWatchPoll(ConfigWatch *watch);
+
 #endif // !CONFIG_H_
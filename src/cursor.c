@@ -4,19 +4,74 @@
 #include "handler.h"
 #include "game.h"
 #include "kmath.h"
+#include "input.h"
+#include "commands.h"
 #include <math.h>
 
-void CursorUpdate(Cursor *cursor, Handler *handler, Camera2D *camera, float dt) {
+// Left click: place, shift keeps placing
+// Right click: cancel
+static void CursorPlace(Cursor *cursor, InputQueue *input) {
+	if(IsMouseButtonPressed(MOUSE_RIGHT_BUTTON)) {
+		cursor->flags &= ~CURSOR_PLACING;
+		return;
+	}
+
+	if(!IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || (cursor->flags & CURSOR_ON_UI)) return;
+
+	InputQueuePush(input, (InputEvent) {
+		.type = INPUT_BUILD,
+		.order = (Order) { .target = cursor->world_position },
+		.prefab = cursor->build_prefab
+	});
+
+	if(!IsKeyDown(KEY_LEFT_SHIFT)) cursor->flags &= ~CURSOR_PLACING;
+}
+
+// 0-9: select group (shift: add to selection)
+// Ctrl + 0-9: selection becomes group
+static void CursorControlGroups(Cursor *cursor, InputQueue *input) {
+	for(uint8_t i = 0; i < CONTROL_GROUP_COUNT; i++) {
+		if(!IsKeyPressed(KEY_ZERO + i)) continue;
+
+		if(IsKeyDown(KEY_LEFT_CONTROL)) {
+			InputQueuePush(input, (InputEvent) { .type = INPUT_GROUP_ASSIGN, .group = i });
+			continue;
+		}
+
+		InputQueuePush(input, (InputEvent) {
+			.type = INPUT_GROUP_SELECT,
+			.group = i,
+			.flags = (IsKeyDown(KEY_LEFT_SHIFT)) ? SELECT_ADD : SELECT_REPLACE
+		});
+	}
+}
+
+void CursorUpdate(Cursor *cursor, Camera2D *camera, InputQueue *input, float dt) {
 	// Set world and screen positions
 	cursor->screen_position = GetMousePosition();
 	cursor->world_position = ScaledVec2WithCamera(cursor->screen_position, camera);
 
+	// Placing takes over both buttons
+	if(cursor->flags & CURSOR_PLACING) {
+		CursorPlace(cursor, input);
+		return;
+	}
+
+	CursorIssueOrders(cursor, input);
+	CursorControlGroups(cursor, input);
+
+	// Left button belongs to minimap until released
+	if(cursor->flags & CURSOR_ON_MINIMAP) return;
+
 	// On press
 	if(IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
-		// Start selection box setting
+		// Start selection box setting, not when pressed over UI
 		if(!(cursor->flags & CURSOR_OPEN_SELECTION)) { 
+			if(!IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || (cursor->flags & CURSOR_ON_UI)) return;
+
 			cursor->flags |= CURSOR_OPEN_SELECTION;
 			cursor->click_position = cursor->screen_position;
+			cursor->selection_rec = (Rectangle) { cursor->click_position.x, cursor->click_position.y, 0, 0 };
 			return;
 		}
 
@@ -38,8 +93,39 @@ void CursorUpdate(Cursor *cursor, Handler *handler, Camera2D *camera, float dt)
 	if(IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
 		// Clear selection box
 		if(cursor->flags & CURSOR_OPEN_SELECTION) {
+			// Shift: add to selection, ctrl: remove from it
+			uint8_t mode = SELECT_REPLACE;
+			if(IsKeyDown(KEY_LEFT_SHIFT)) mode = SELECT_ADD;
+			else if(IsKeyDown(KEY_LEFT_CONTROL)) mode = SELECT_REMOVE;
+
+			bool click = (cursor->selection_rec.width < CURSOR_CLICK_DISTANCE && cursor->selection_rec.height < CURSOR_CLICK_DISTANCE);
+			bool double_click = click && (GetTime() - cursor->last_click_time < CURSOR_DOUBLE_CLICK_TIME) && 
+				Vector2Distance(cursor->click_position, cursor->last_click_position) < CURSOR_CLICK_DISTANCE;
+
+			if(double_click) {
+				Rectangle view = (Rectangle) { 0, 0, GetScreenWidth(), GetScreenHeight() };
 
-			CheckSelectedUnits(handler, cursor->selection_rec);
+				InputQueuePush(input, (InputEvent) {
+					.type = INPUT_SELECT_TYPE,
+					.rec = ScaledRecWithCamera(view, camera),
+					.order = (Order) { .target = cursor->world_position },
+					.flags = mode
+				});
+
+				// Third click starts over
+				cursor->last_click_time = 0;
+			} else {
+				InputQueuePush(input, (InputEvent) {
+					.type = INPUT_SELECT,
+					.rec = ScaledRecWithCamera(cursor->selection_rec, camera),
+					.flags = mode
+				});
+
+				if(click) {
+					cursor->last_click_time = GetTime();
+					cursor->last_click_position = cursor->click_position;
+				}
+			}
 
 			cursor->selection_rec = (Rectangle) { 0 };
 			cursor->flags &= ~CURSOR_OPEN_SELECTION;
@@ -47,16 +133,59 @@ void CursorUpdate(Cursor *cursor, Handler *handler, Camera2D *camera, float dt)
 	}
 }
 
+void CursorIssueOrders(Cursor *cursor, InputQueue *input) {
+	// Right click: move (ctrl: attack-move, alt: patrol)
+	// H: hold position
+	// Shift: queue order after current ones
+	bool order_move = IsMouseButtonPressed(MOUSE_RIGHT_BUTTON) && !(cursor->flags & CURSOR_ON_UI);
+	bool order_hold = IsKeyPressed(KEY_H);
+
+	if(!order_move && !order_hold) return;
+
+	Order order = (Order) {
+		.target = cursor->world_position,
+		.type = ORDER_MOVE
+	};
+
+	if(order_hold) 
+		order.type = ORDER_HOLD;
+	else if(IsKeyDown(KEY_LEFT_CONTROL)) 
+		order.type = ORDER_ATTACK_MOVE;
+	else if(IsKeyDown(KEY_LEFT_ALT)) 
+		order.type = ORDER_PATROL;
+
+	uint8_t flags = (IsKeyDown(KEY_LEFT_SHIFT)) ? CMD_QUEUE : 0;
+
+	// Selection is resolved by the simulation, once per order
+	InputQueuePush(input, (InputEvent) {
+		.type = INPUT_ORDER,
+		.order = order,
+		.flags = flags
+	});
+}
+
+void CursorBeginPlacing(Cursor *cursor, uint16_t prefab) {
+	cursor->build_prefab = prefab;
+	cursor->flags |= CURSOR_PLACING;
+
+	// Drop a selection box in progress
+	cursor->flags &= ~CURSOR_OPEN_SELECTION;
+	cursor->selection_rec = (Rectangle) { 0 };
+}
+
 void CursorDraw(Cursor *cursor) {
 	DrawCircleV(cursor->screen_position, 5, SKYBLUE);
 
+	if(cursor->flags & CURSOR_PLACING)
+		DrawCircleLinesV(cursor->screen_position, 16, GOLD);
+
 	if(cursor->flags & CURSOR_OPEN_SELECTION) {
 		DrawRectangleRec(cursor->selection_rec, ColorAlpha(RAYWHITE, 0.5f));
 		DrawRectangleLinesEx(cursor->selection_rec, 2, RAYWHITE);
 	}
 }
 
-void CursorCameraControls(Cursor *cursor, Camera2D *camera, float dt) {
+void CursorCameraControls(Cursor *cursor, Camera2D *camera, Minimap *minimap, float dt) {
 	// Track previous camera target
 	Vector2 prev = ScaledVec2WithCamera(cursor->screen_position, camera);
 
@@ -68,14 +197,33 @@ void CursorCameraControls(Cursor *cursor, Camera2D *camera, float dt) {
 	if(IsKeyDown(KEY_W)) key_direction.y--;
 	if(IsKeyDown(KEY_S)) key_direction.y++;
 
-	camera->target = Vector2Add(camera->target, Vector2Scale(key_direction, 1000 * dt));
+	// Same speed on screen at every zoom
+	camera->target = Vector2Add(camera->target, Vector2Scale(key_direction, 1000 * dt / camera->zoom));
+
+	// Click or drag on minimap centers view there
+	if(IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && MinimapContains(minimap, cursor->screen_position)) {
+		cursor->flags |= CURSOR_ON_MINIMAP;
+
+		// Press already opened a selection box this frame
+		cursor->flags &= ~CURSOR_OPEN_SELECTION;
+		cursor->selection_rec = (Rectangle) { 0 };
+	}
+
+	if(cursor->flags & CURSOR_ON_MINIMAP) {
+		if(!IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
+			cursor->flags &= ~CURSOR_ON_MINIMAP;
+		} else {
+			Vector2 view = Vector2Scale((Vector2){ VIRTUAL_WIDTH, VIRTUAL_HEIGHT }, 0.5f / camera->zoom);
+			camera->target = Vector2Subtract(MinimapToWorld(minimap, cursor->screen_position), view);
+		}
+	}
 
 	// Zoom in & out
 	float scroll = GetMouseWheelMove();
 	if(fabsf(scroll) > 0) {
 		float amount = pow(scroll, 7.0f);
 		camera->zoom += (amount) * dt;
-		camera->zoom = Clamp(camera->zoom, 0.5f, 2.0f);
+		camera->zoom = Clamp(camera->zoom, CAMERA_ZOOM_MIN, CAMERA_ZOOM_MAX);
 
 		Vector2 next = ScaledVec2WithCamera(cursor->screen_position, camera);
 
@@ -1,11 +1,24 @@
 #include <stdint.h>
 #include "raylib.h"
 #include "handler.h"
+#include "input.h"
+#include "minimap.h"
 
 #ifndef CURSOR_H_
 #define CURSOR_H_
 
 #define CURSOR_OPEN_SELECTION	0x01
+#define CURSOR_ON_MINIMAP		0x02	// Left button went down on minimap, held for camera jumps
+#define CURSOR_ON_UI			0x04	// Mouse is over a panel or the minimap, clicks don't reach the world
+#define CURSOR_PLACING			0x08	// Left click places 'build_prefab', right click cancels
+
+// Second click within this many seconds and window pixels selects all units of that type in view
+#define CURSOR_DOUBLE_CLICK_TIME	0.3
+#define CURSOR_CLICK_DISTANCE		4.0f
+
+// Camera zoom range, far end is strategic view
+#define CAMERA_ZOOM_MIN		0.1f
+#define CAMERA_ZOOM_MAX		2.0f
 
 typedef struct {
 	Rectangle selection_rec;
@@ -15,13 +28,26 @@ typedef struct {
 	Vector2 click_position;
 	Vector2 virt_position;
 
+	// Last plain click, for double clicks
+	Vector2 last_click_position;
+	double last_click_time;
+
+	uint16_t build_prefab;
+
 	uint8_t flags;
 
 } Cursor;
 
-void CursorUpdate(Cursor *cursor, Handler *handler, Camera2D *camera, float dt);
+void CursorUpdate(Cursor *cursor, Camera2D *camera, InputQueue *input, float dt);
+
+// Turn input into orders for selected units
+void CursorIssueOrders(Cursor *cursor, InputQueue *input);
 void CursorDraw(Cursor *cursor);
 
-void CursorCameraControls(Cursor *cursor, Camera2D *camera, float dt);
+// Next left click places prefab instead of selecting
+void CursorBeginPlacing(Cursor *cursor, uint16_t prefab);
+
+// Key panning, zoom and minimap click-to-jump
+void CursorCameraControls(Cursor *cursor, Camera2D *camera, Minimap *minimap, float dt);
 
 #endif
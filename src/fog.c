@@ -0,0 +1,70 @@
+#include <stdint.h>
+#include <string.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "fog.h"
+#include "render.h"
+#include "visibility.h"
+#include "memory.h"
+
+// Overlay color per 'VISION_STATES'
+static Color fog_colors[] = {
+	[VISION_HIDDEN]   = { 0, 0, 0, 235 },
+	[VISION_EXPLORED] = { 0, 0, 0, 140 },
+	[VISION_VISIBLE]  = { 0, 0, 0, 0 }
+};
+
+void FogInit(FogLayer *fog, CellLayout layout) {
+	uint32_t cell_count = layout.cols * layout.rows;
+
+	*fog = (FogLayer) {
+		.cells = TrackedMalloc(cell_count),
+		.layout = layout,
+		.tick = UINT32_MAX
+	};
+
+	// No valid state, first update writes every cell
+	memset(fog->cells, 0xFF, cell_count);
+
+	CellTextureInit(&fog->texture, layout.cols, layout.rows);
+	SetTextureFilter(fog->texture.texture, TEXTURE_FILTER_BILINEAR);
+}
+
+void FogClose(FogLayer *fog) {
+	CellTextureClose(&fog->texture);
+	TrackedFree(fog->cells);
+
+	*fog = (FogLayer) { 0 };
+}
+
+void FogUpdate(FogLayer *fog, RenderState *state) {
+	if(!fog->cells || state->tick == fog->tick || !state->vision_layout.cols) return;
+
+	if(!CellLayoutEqual(&state->vision_layout, &fog->layout)) {
+		FogClose(fog);
+		FogInit(fog, state->vision_layout);
+	}
+
+	fog->tick = state->tick;
+
+	for(uint16_t r = 0; r < fog->layout.rows; r++) {
+		for(uint16_t c = 0; c < fog->layout.cols; c++) {
+			uint32_t i = c + r * fog->layout.cols;
+			if(state->cell_vision[i] == fog->cells[i]) continue;
+
+			fog->cells[i] = state->cell_vision[i];
+			CellTextureSet(&fog->texture, c, r, fog_colors[fog->cells[i]]);
+		}
+	}
+
+	CellTextureUpload(&fog->texture);
+}
+
+void FogDraw(FogLayer *fog) {
+	if(!fog->texture.texture.id) return;
+
+	Rectangle src = (Rectangle) { 0, 0, fog->layout.cols, fog->layout.rows };
+	Rectangle dest = CellLayoutBounds(&fog->layout);
+
+	DrawTexturePro(fog->texture.texture, src, dest, Vector2Zero(), 0, WHITE);
+}
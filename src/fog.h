@@ -0,0 +1,36 @@
+#include <stdint.h>
+#include "raylib.h"
+#include "render.h"
+
+#ifndef FOG_H_
+#define FOG_H_
+
+// *
+// Fog of war overlay, one texture pixel per grid cell stretched over the world
+//
+// Like the minimap, only cells whose fog state changed since the last state seen
+// are rewritten and uploaded. Filtering blends cell edges into soft borders.
+// *
+typedef struct {
+	CellTexture texture;
+
+	// 'VISION_STATES' pixels were built from
+	uint8_t *cells;
+
+	CellLayout layout;
+
+	// Tick of last state applied
+	uint32_t tick;
+
+} FogLayer;
+
+// Needs graphics context
+void FogInit(FogLayer *fog, CellLayout layout);
+void FogClose(FogLayer *fog);
+
+void FogUpdate(FogLayer *fog, RenderState *state);
+
+// Call inside 'BeginMode2D', after everything fog should cover
+void FogDraw(FogLayer *fog);
+
+#endif
@@ -2,12 +2,28 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include "raylib.h"
 #include "raymath.h"
 #include "game.h"
 #include "config.h"
 #include "sprites.h"
 #include "kmath.h"
+#include "memory.h"
+#include "profiler.h"
+#include "commands.h"
+#include "sim.h"
+#include "input.h"
+#include "render.h"
+#include "particles.h"
+#include "layers.h"
+#include "resolution.h"
+#include "minimap.h"
+#include "fog.h"
+#include "ui.h"
+#include "rlgl.h"
+#include "level.h"
+#include "prefabs.h"
 
 Texture2D controls;
 
@@ -23,11 +39,15 @@ typedef void(*DrawFunc)(Game *game, uint8_t flags);
 UpdateFunc game_update_fn[] = { TitleUpdate, MainUpdate, OverScreenUpdate };
 DrawFunc game_draw_fn[] = { TitleDraw, MainDraw, OverScreenDraw };
 
+typedef void(*UiFunc)(Game *game);
+UiFunc game_ui_fn[] = { TitleUi, MainUi, OverScreenUi };
+
 // Initialize data, allocate memory, etc.
 void GameInit(Game *game) {
 	// Initialize config struct and read options from file
 	game->conf = (Config) { 0 };
-	ConfigRead(&game->conf, "options.conf");
+	ConfigRead(&game->conf, CONFIG_PATH);
+	ConfigWatchInit(&game->conf_watch, CONFIG_PATH);
 
 	// Initialize camera
 	game->cam = (Camera2D) {
@@ -41,55 +61,221 @@ void GameInit(Game *game) {
 	// Initialize cursor
 	game->cursor = (Cursor) { 0 };
 
+	// Unit detail thresholds
+	game->lod = (RenderLod) {
+		.mid_zoom = (game->conf.lod_mid_zoom > 0) ? game->conf.lod_mid_zoom : CONFIG_DEFAULT_LOD_MID,
+		.far_zoom = (game->conf.lod_far_zoom > 0) ? game->conf.lod_far_zoom : CONFIG_DEFAULT_LOD_FAR
+	};
+
+	// Initialize command buffer and input queue
+	CommandBufferInit(&game->commands);
+	InputQueueInit(&game->input);
+
+	// Initialize per-frame arena
+	ArenaInit(&game->frame_arena, FRAME_ARENA_SIZE);
+	ProfilerWatchArena(&game->frame_arena);
+
+	// Initialize simulation
+	// Replays provide their own seed and tick rate, live sessions are seeded from time
+	SimInit(&game->sim, game->conf.tick_rate);
+	uint64_t seed = (uint64_t)time(NULL);
+
+	if(game->replay_path && SimPlayback(&game->sim, game->replay_path))
+		seed = game->sim.replay.seed;
+
+	// Unit templates, before handler spawns anything
+	PrefabsLoad("resources/prefabs.pfb");
+
 	// Initialize handler
-	HandlerInit(&game->handler, &game->cam, 0);
+	HandlerInit(&game->handler, &game->sim.tick_arena, seed);
+
+	// Grid settings, applied when the level fits the grid to its bounds
+	game->handler.grid_tuning.cell_size = game->conf.grid_cell_size;
+	game->handler.grid_tuning.offset = (Vector2) { game->conf.grid_offset_x, game->conf.grid_offset_y };
+	game->handler.grid_tuning.cell_cap = game->conf.cell_ent_cap;
+	game->handler.grid_tuning.auto_tune = game->conf.grid_auto_tune && !game->record_path;
+
+	// Replays store the fitted grid and level, options and level path are ignored
+	char *level_path = game->conf.level_path;
+
+	if(game->sim.flags & SIM_PLAYBACK) {
+		SimPinGrid(&game->sim, &game->handler);
+		level_path = game->sim.replay.level.path;
+	}
+
+	// Load waves, before recording so replays start from the same level
+	// Without a level the default area is refitted with the settings above
+	bool level_loaded = level_path[0] && LevelLoad(&game->handler, level_path);
+
+	if(!level_loaded)
+		HandlerFitGrid(&game->handler, game->handler.grid_tuning.bounds);
+
+	// Render states are sized for every entity being drawn
+	RenderBufferInit(&game->render, ENTITY_CAP, ENTITY_CAP * ORDER_QUEUE_CAP, PROJECTILE_CAP);
+	ParticlesInit(&game->particles, (game->conf.particle_budget) ? game->conf.particle_budget : CONFIG_DEFAULT_PB);
+
+	// Start recording once initial state is set
+	if(game->record_path && !(game->sim.flags & SIM_PLAYBACK))
+		SimRecord(&game->sim, &game->handler, game->record_path, seed, (level_loaded) ? level_path : NULL);
+
+	// Resume from saved state (eg. autosave after a crash)
+	if(game->load_path)
+		SimLoad(&game->sim, &game->handler, &game->commands, game->load_path);
 
 	// Start gameplay
 	MainStart(game);
 }
 
+// Use part of render target matching current resolution scale
+static void GameRenderResize(Game *game) {
+	float w = roundf(VIRTUAL_WIDTH * game->dynres.scale);
+	float h = roundf(VIRTUAL_HEIGHT * game->dynres.scale);
+
+	game->render_src_rec = (Rectangle) { 0, 0, w, -h };
+}
+
 // Initialize necessary data for rendering the game 
 void GameRenderInit(Game *game) {
+	Config *conf = &game->conf;
+
+	DynResInit(&game->dynres, conf->dynamic_resolution,
+		(conf->resolution_min > 0) ? conf->resolution_min : CONFIG_DEFAULT_RMIN,
+		(conf->resolution_max > 0) ? conf->resolution_max : CONFIG_DEFAULT_RMAX,
+		(conf->refresh_rate > 0) ? conf->refresh_rate : CONFIG_DEFAULT_RR);
+
 	// Load empty texture, used as buffer for scaling
-	render_target = LoadRenderTexture(VIRTUAL_WIDTH, VIRTUAL_HEIGHT);
-	SetTextureFilter(render_target.texture, TEXTURE_FILTER_POINT);
+	// Sized for the highest scale, lower ones only draw into a corner of it
+	float max_scale = (game->dynres.enabled) ? game->dynres.max : 1.0f;
+	render_target = LoadRenderTexture(ceilf(VIRTUAL_WIDTH * max_scale), ceilf(VIRTUAL_HEIGHT * max_scale));
+
+	// Upscaling by fractions needs filtering
+	SetTextureFilter(render_target.texture, (game->dynres.enabled) ? TEXTURE_FILTER_BILINEAR : TEXTURE_FILTER_POINT);
 
 	// Set source and destination rectangle values for window scaling
-	game->render_src_rec  = (Rectangle) { 0, 0, VIRTUAL_WIDTH, -VIRTUAL_HEIGHT };
+	GameRenderResize(game);
 	game->render_dest_rec = (Rectangle) { 0, 0, game->conf.window_width, game->conf.window_height };
 
-	ScaleInit(game->render_src_rec, game->render_dest_rec);
+	// Cursor maps window to virtual units, independent of render target size
+	ScaleInit((Rectangle) { 0, 0, VIRTUAL_WIDTH, VIRTUAL_HEIGHT }, game->render_dest_rec);
 }
 
 // Initialize sprite loader struct, load assets
 void GameContentInit(Game *game) {
+	ParticlesLoadTextures(&game->particles);
+	LayersInit(&game->layers);
+
+	// Minimap in bottom right corner of window
+	// Both follow the layouts of render states from here on
+	float size = game->conf.window_height * 0.2f;
+	Rectangle bounds = (Rectangle) { game->conf.window_width - size - 16, game->conf.window_height - size - 16, size, size };
+
+	MinimapInit(&game->minimap, game->handler.visibility.layout, bounds);
+	FogInit(&game->fog, game->handler.visibility.layout);
+
+	UiInit(&game->ui);
+}
+
+void GameSimStart(Game *game) {
+	if(!game->conf.sim_thread) return;
+
+	game->sim_thread = (SimThread) {
+		.sim = &game->sim,
+		.handler = &game->handler,
+		.commands = &game->commands,
+		.input = &game->input,
+		.render = &game->render
+	};
+
+	SimThreadStart(&game->sim_thread);
+}
+
+// Push options that can change while running to where they're used
+static void GameApplyConfig(Game *game) {
+	Config *conf = &game->conf;
+
+	game->lod.mid_zoom = conf->lod_mid_zoom;
+	game->lod.far_zoom = conf->lod_far_zoom;
+
+	if(conf->particle_budget != game->particles.capacity)
+		ParticlesResize(&game->particles, conf->particle_budget);
+
+	// Frame budget follows refresh rate, lowest scale can't go past what the target was sized for
+	SetTargetFPS(conf->refresh_rate);
+	game->dynres.target_ms = 1000.0f / conf->refresh_rate;
+	game->dynres.min = fminf(conf->resolution_min, game->dynres.max);
+
+	// Simulation may be on another thread, rate changes between ticks
+	InputQueuePush(&game->input, (InputEvent) { .type = INPUT_TICK_RATE, .amount = conf->tick_rate });
+	InputQueuePush(&game->input, (InputEvent) { .type = INPUT_GRID, .amount = conf->grid_cell_size, .cell_cap = conf->cell_ent_cap });
 }
 
 void GameUpdate(Game *game) {
+	// Start of frame, release last frame's transient allocations
+	ProfilerBeginFrame();
+	ArenaReset(&game->frame_arena);
+
+	ProfileBegin(PROF_UPDATE);
+
 	// Get delta time once only, pass to other update functions
 	float delta_time = GetFrameTime();
 
+	if(ConfigWatchPoll(&game->conf_watch) && ConfigReload(&game->conf, CONFIG_PATH))
+		GameApplyConfig(game);
+
 	// Send quit request on hitting escape
 	if(IsKeyPressed(KEY_ESCAPE))
 		game->flags |= GAME_QUIT_REQUEST;
 
+	// Widgets first, state update knows whether the mouse is taken
+	ProfileBegin(PROF_UI);
+	UiBegin(&game->ui, GetMousePosition(), IsMouseButtonDown(MOUSE_LEFT_BUTTON));
+	game_ui_fn[game->state](game);
+	UiEnd(&game->ui);
+	ProfileEnd(PROF_UI);
+
 	// Call state appropriate update function
 	game_update_fn[game->state](game, delta_time);
+
+	ProfileEnd(PROF_UPDATE);
 }
 
 // Render game to buffer texture
 void GameDrawToBuffer(Game *game, uint8_t flags) {
+	// Adjust resolution from last frame's timings
+	float work_ms = ProfileZoneMs(PROF_UPDATE) + ProfileZoneMs(PROF_DRAW_BUFFER) + ProfileZoneMs(PROF_DRAW_WINDOW);
+	if(DynResUpdate(&game->dynres, GetFrameTime(), work_ms)) GameRenderResize(game);
+
+	ProfileBegin(PROF_DRAW_BUFFER);
+
+	// Cached tiles render to their own textures, texture modes can't nest
+	if(game->state == GAME_MAIN) {
+		RenderState *state = RenderBufferAcquire(&game->render);
+		LayersPrepare(&game->layers, &state->statics, &game->cam);
+	}
+
 	BeginTextureMode(render_target);
 	ClearBackground((Color){0});
 
+	// Map virtual units onto the part of the target in use
+	rlViewport(0, 0, game->render_src_rec.width, -game->render_src_rec.height);
+	rlMatrixMode(RL_PROJECTION);
+	rlLoadIdentity();
+	rlOrtho(0, VIRTUAL_WIDTH, VIRTUAL_HEIGHT, 0, 0.0f, 1.0f);
+	rlMatrixMode(RL_MODELVIEW);
+	rlLoadIdentity();
+
 	// Call state appropriate draw function
 	game_draw_fn[game->state](game, flags);
 
 	EndTextureMode();
+
+	ProfileEnd(PROF_DRAW_BUFFER);
 }
 
 // Render buffer onto window
 void GameDrawToWindow(Game *game) {
+	ProfileBegin(PROF_DRAW_WINDOW);
+
 	BeginDrawing();
 
 	ClearBackground((Color){0});
@@ -98,18 +284,52 @@ void GameDrawToWindow(Game *game) {
 	DrawTexturePro(render_target.texture, game->render_src_rec, game->render_dest_rec, Vector2Zero(), 0, WHITE);
 
 	// Draw overlays
+	if(game->state == GAME_MAIN) MinimapDraw(&game->minimap, &game->cam);
+	UiDraw(&game->ui);
+
 	DrawFPS(0, 0);
 	CursorDraw(&game->cursor);
 
+	if(game->conf.debug_flags & SHOW_PROFILER)
+		ProfilerDraw(0, 24);
+
 	//DrawCircleV(game->cursor.virt_position, 5, GREEN);
 
+	// Stop timing before buffer swap, exclude vsync wait
+	ProfileEnd(PROF_DRAW_WINDOW);
+
 	EndDrawing();
 }
 
 // Free allocated memory for buffer texture and assets 
 void GameClose(Game *game) {
+	// Stop simulation before touching its data
+	SimThreadStop(&game->sim_thread);
+
 	UnloadRenderTexture(render_target);
+	RenderBufferClose(&game->render);
+	ParticlesClose(&game->particles);
+	LayersClose(&game->layers);
+	MinimapClose(&game->minimap);
+	FogClose(&game->fog);
+	UiClose(&game->ui);
+	SimClose(&game->sim, &game->handler);
 	HandlerClose(&game->handler);
+	CommandBufferClose(&game->commands);
+	ArenaClose(&game->frame_arena);
+	ConfigWatchClose(&game->conf_watch);
+}
+
+void TitleUi(Game *game) {
+	float width = 320;
+	Rectangle rec = (Rectangle) { (game->conf.window_width - width) * 0.5f, game->conf.window_height * 0.4f, width, 0 };
+
+	UiPanelBegin(&game->ui, rec, "SPACE TD");
+
+	if(UiButton(&game->ui, "Start")) MainStart(game);
+	if(UiButton(&game->ui, "Quit")) game->flags |= GAME_QUIT_REQUEST;
+
+	UiPanelEnd(&game->ui);
 }
 
 // Update title screen UI elements, start gameplay on user input
@@ -123,21 +343,121 @@ void TitleUpdate(Game *game, float delta_time) {
 void TitleDraw(Game *game, uint8_t flags) {
 }
 
+// Status, selection roster and build menu
+void MainUi(Game *game) {
+	Ui *ui = &game->ui;
+	RenderState *state = RenderBufferAcquire(&game->render);
+
+	float width = 240;
+	float w = game->conf.window_width;
+	float h = game->conf.window_height;
+
+	// Status, top right
+	UiPanelBegin(ui, (Rectangle) { w - width - 16, 16, width, 0 }, "Status");
+	UiCounter(ui, "Units", state->unit_count);
+	UiCounter(ui, "Enemies", state->enemy_count);
+
+	uint16_t wave = (state->wave < state->wave_count) ? state->wave + 1 : state->wave_count;
+	UiLabel(ui, TextFormat("Wave %d / %d", wave, state->wave_count));
+
+	if(state->wave < state->wave_count && state->wave_timer > 0)
+		UiLabel(ui, TextFormat("Next in %ds", (int)ceilf(state->wave_timer)));
+
+	UiPanelEnd(ui);
+
+	// Selection roster, top center
+	if(state->selected_count) {
+		float roster_width = 360;
+
+		UiPanelBegin(ui, (Rectangle) { (w - roster_width) * 0.5f, 16, roster_width, 0 }, "Selection");
+		UiCounter(ui, "Units", state->selected_count);
+		UiBoxes(ui, state->selected_count, 4, SKYBLUE);
+		UiPanelEnd(ui);
+	}
+
+	// Build menu, bottom left
+	uint8_t rows = 1;
+
+	for(uint16_t i = 0; i < prefab_count; i++)
+		if(PrefabBuildable(&prefabs[i])) rows++;
+
+	bool placing = (game->cursor.flags & CURSOR_PLACING);
+	if(placing) rows++;
+
+	UiPanelBegin(ui, (Rectangle) { 16, h - UI_PANEL_HEIGHT(rows) - 16, width, UI_PANEL_HEIGHT(rows) }, "Build");
+
+	for(uint16_t i = 0; i < prefab_count; i++) {
+		if(!PrefabBuildable(&prefabs[i])) continue;
+		if(UiButton(ui, prefabs[i].name)) CursorBeginPlacing(&game->cursor, i);
+	}
+
+	if(placing) UiLabel(ui, "Right click cancels");
+
+	UiPanelEnd(ui);
+}
+
 // Main gameplay loop logic
 void MainUpdate(Game *game, float delta_time) {
-	CursorUpdate(&game->cursor, &game->handler, &game->cam, delta_time);
-	CursorCameraControls(&game->cursor, &game->cam, delta_time);
+	// Clicks on panels and minimap don't reach the world
+	if(UiWantsMouse(&game->ui) || MinimapContains(&game->minimap, GetMousePosition()))
+		game->cursor.flags |= CURSOR_ON_UI;
+	else
+		game->cursor.flags &= ~CURSOR_ON_UI;
+
+	CursorUpdate(&game->cursor, &game->cam, &game->input, delta_time);
+	CursorCameraControls(&game->cursor, &game->cam, &game->minimap, delta_time);
+
+	// Save states:
+	// F5: quick save, F9: quick load, F6: rewind one second
+	if(IsKeyPressed(KEY_F5)) InputQueuePush(&game->input, (InputEvent) { .type = INPUT_SAVE });
+	if(IsKeyPressed(KEY_F9)) InputQueuePush(&game->input, (InputEvent) { .type = INPUT_LOAD });
+	if(IsKeyPressed(KEY_F6)) InputQueuePush(&game->input, (InputEvent) { .type = INPUT_REWIND, .amount = 1.0f });
 
-	HandlerUpdate(&game->handler, delta_time);
+	// Simulation thread handles everything else
+	if(game->sim_thread.running) return;
+
+	// Run fixed simulation ticks, orders are applied in one batch at the start of each
+	SimDrainInput(&game->sim, &game->handler, &game->commands, &game->input);
+
+	ProfileBegin(PROF_SIM);
+	bool ticked = SimAdvance(&game->sim, &game->handler, &game->commands, delta_time);
+	ProfileEnd(PROF_SIM);
+
+	// Latest tick became current 'accumulator' seconds ago
+	if(ticked) SimPublish(&game->sim, &game->handler, &game->render, GetTime() - game->sim.accumulator);
 }
 
 // Render objects to buffer texture
 void MainDraw(Game *game, uint8_t flags) {
+	RenderState *state = RenderBufferAcquire(&game->render);
+
+	ProfileBegin(PROF_PARTICLES);
+	ParticlesUpdate(&game->particles, state, GetFrameTime());
+	ProfileEnd(PROF_PARTICLES);
+
+	MinimapUpdate(&game->minimap, state);
+	FogUpdate(&game->fog, state);
+
+	// Static world under everything that moves
+	LayersDrawBackground(&game->layers, &game->cam);
+
 	BeginMode2D(game->cam);
-	HandlerDraw(&game->handler);
+	LayersDrawStatics(&game->layers, &state->statics, &game->cam);
+	RenderStateDraw(state, &game->cam, &game->lod);
+	ParticlesDraw(&game->particles);
+	FogDraw(&game->fog);
 	EndMode2D();
 }
 
+void OverScreenUi(Game *game) {
+	float width = 320;
+	Rectangle rec = (Rectangle) { (game->conf.window_width - width) * 0.5f, game->conf.window_height * 0.4f, width, 0 };
+
+	UiPanelBegin(&game->ui, rec, "Game over");
+	if(UiButton(&game->ui, "Quit")) game->flags |= GAME_QUIT_REQUEST;
+	UiPanelEnd(&game->ui);
+}
+
 void OverScreenUpdate(Game *game, float delta_time) {
 }
 
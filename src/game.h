@@ -4,6 +4,17 @@
 #include "sprites.h"
 #include "handler.h"
 #include "cursor.h"
+#include "memory.h"
+#include "commands.h"
+#include "sim.h"
+#include "input.h"
+#include "render.h"
+#include "particles.h"
+#include "layers.h"
+#include "resolution.h"
+#include "minimap.h"
+#include "fog.h"
+#include "ui.h"
 
 #ifndef GAME_H_
 #define GAME_H_
@@ -37,11 +48,58 @@ typedef struct {
 	Config conf;
 	Camera2D cam;
 
+	// Options file changes, live options are applied on the fly
+	ConfigWatch conf_watch;
+
 	Cursor cursor;
 
+	// Unit orders issued this frame
+	CommandBuffer commands;
+
+	// Fixed tick simulation driver
+	Sim sim;
+
+	// Simulation thread, only running if enabled in config
+	SimThread sim_thread;
+
+	// Player actions, main thread to simulation
+	InputQueue input;
+
+	// Render states, simulation to main thread
+	RenderBuffer render;
+
+	// Visual effects, main thread only
+	Particles particles;
+
+	// Cached background and static scenery, main thread only
+	RenderLayers layers;
+
+	// Zoom thresholds for unit detail
+	RenderLod lod;
+
+	// Grid occupancy overview, main thread only
+	Minimap minimap;
+
+	// Fog of war overlay, main thread only
+	FogLayer fog;
+
+	// Menus and HUD, rebuilt every frame
+	Ui ui;
+
+	// Command line options, NULL if not set
+	char *record_path;
+	char *replay_path;
+	char *load_path;
+
+	// Transient allocations, reset at the start of every update
+	Arena frame_arena;
+
+	// Part of render target in use, changes with dynamic resolution
 	Rectangle render_src_rec;
 	Rectangle render_dest_rec;
 
+	DynamicResolution dynres;
+
 	uint8_t flags; 
 	uint8_t state;
 } Game;
@@ -50,6 +108,9 @@ void GameInit(Game *game);
 void GameRenderInit(Game *game);
 void GameContentInit(Game *game);
 
+// Start simulation thread if enabled, call after window is open
+void GameSimStart(Game *game);
+
 void GameUpdate(Game *game);
 
 void GameDrawToBuffer(Game *game, uint8_t flags);
@@ -57,6 +118,11 @@ void GameDrawToWindow(Game *game);
 
 void GameClose(Game *game);
 
+// Widgets of each state, recorded before its update so clicks on them don't reach the world
+void TitleUi(Game *game);
+void MainUi(Game *game);
+void OverScreenUi(Game *game);
+
 void TitleUpdate(Game *game, float delta_time);
 void TitleDraw(Game *game, uint8_t flags);
 
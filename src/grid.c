@@ -0,0 +1,295 @@
+#include <stdint.h>
+#include <stdio.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "handler.h"
+#include "memory.h"
+#include "profiler.h"
+
+// Cell coordinates mixed into a table index
+static uint32_t GridSparseHash(int32_t c, int32_t r) {
+	uint32_t h = (uint32_t)c * 0x9E3779B1u ^ (uint32_t)r * 0x85EBCA77u;
+	return h ^ (h >> 16);
+}
+
+// Slot holding cell at coordinates, or the empty slot its probe ends on
+static uint32_t GridSparseSlot(Grid *grid, int32_t c, int32_t r) {
+	uint32_t i = GridSparseHash(c, r) & grid->slot_mask;
+
+	while(grid->slots[i].cell >= 0 && (grid->slots[i].col != c || grid->slots[i].row != r))
+		i = (i + 1) & grid->slot_mask;
+
+	return i;
+}
+
+GridCell *GridSparseFind(Grid *grid, int32_t c, int32_t r) {
+	GridSlot *slot = &grid->slots[GridSparseSlot(grid, c, r)];
+	return (slot->cell >= 0) ? &grid->cells[slot->cell] : NULL;
+}
+
+// Double table slots, occupied ones are placed again
+static void GridSparseGrowTable(Grid *grid) {
+	GridSlot *old = grid->slots;
+	uint32_t old_count = grid->slot_mask + 1;
+	uint32_t count = old_count * 2;
+
+	grid->slots = TrackedMalloc(count * sizeof(GridSlot));
+	grid->slot_mask = count - 1;
+
+	for(uint32_t i = 0; i < count; i++) 
+		grid->slots[i].cell = -1;
+
+	for(uint32_t i = 0; i < old_count; i++) 
+		if(old[i].cell >= 0) grid->slots[GridSparseSlot(grid, old[i].col, old[i].row)] = old[i];
+
+	TrackedFree(old);
+}
+
+// Double pool cells, false if it can't grow (an entity is in one cell at most, so it never has to)
+static bool GridSparseGrowPool(Grid *grid) {
+	uint32_t count = (grid->cell_count) ? grid->cell_count * 2 : GRID_SPARSE_MIN_CELLS;
+	if(count > ENTITY_CAP) count = ENTITY_CAP;
+	if(count <= grid->cell_count) return false;
+
+	grid->cells = TrackedRealloc(grid->cells, count * sizeof(GridCell));
+	grid->entries = TrackedRealloc(grid->entries, count * grid->cell_cap * sizeof(INT_N));
+	grid->free_cells = TrackedRealloc(grid->free_cells, count * sizeof(INT_N));
+
+	// Entries moved, cells point into the new block
+	for(uint32_t i = 0; i < count; i++) 
+		grid->cells[i].entities = &grid->entries[i * grid->cell_cap];
+
+	// New cells are handed out lowest first
+	for(uint32_t i = count; i-- > grid->cell_count;) {
+		grid->cells[i].entity_count = 0;
+		grid->free_cells[grid->free_count++] = i;
+	}
+
+	grid->cell_count = count;
+
+	return true;
+}
+
+GridCell *GridSparseAcquire(Grid *grid, int32_t c, int32_t r) {
+	uint32_t i = GridSparseSlot(grid, c, r);
+	if(grid->slots[i].cell >= 0) return &grid->cells[grid->slots[i].cell];
+
+	if(!grid->free_count && !GridSparseGrowPool(grid)) return NULL;
+
+	// Table stays at most half full, probes stay short
+	if((uint32_t)(grid->occupied + 1) * 2 > grid->slot_mask + 1) {
+		GridSparseGrowTable(grid);
+		i = GridSparseSlot(grid, c, r);
+	}
+
+	INT_N id = grid->free_cells[--grid->free_count];
+
+	GridCell *cell = &grid->cells[id];
+	cell->col = c;
+	cell->row = r;
+	cell->entity_count = 0;
+
+	grid->slots[i] = (GridSlot) { .col = c, .row = r, .cell = id };
+	grid->occupied++;
+
+	return cell;
+}
+
+void GridSparseRelease(Grid *grid, GridCell *cell) {
+	uint32_t mask = grid->slot_mask;
+	uint32_t hole = GridSparseSlot(grid, cell->col, cell->row);
+	if(grid->slots[hole].cell < 0) return;
+
+	grid->free_cells[grid->free_count++] = grid->slots[hole].cell;
+	grid->occupied--;
+
+	// Close the gap without tombstones: later slots of the run move back into it,
+	// unless that would put them before the slot they hash to
+	for(uint32_t i = (hole + 1) & mask; grid->slots[i].cell >= 0; i = (i + 1) & mask) {
+		uint32_t home = GridSparseHash(grid->slots[i].col, grid->slots[i].row) & mask;
+		if(((i - home) & mask) < ((i - hole) & mask)) continue;
+
+		grid->slots[hole] = grid->slots[i];
+		hole = i;
+	}
+
+	grid->slots[hole].cell = -1;
+}
+
+// Sparse grids only keep origin and cell size of their layout
+static CellLayout GridSparseLayout(Vector2 origin, float cell_size) {
+	return (CellLayout) {
+		.origin = origin,
+		.cell_size = (Vector2) { cell_size, cell_size }
+	};
+}
+
+void GridRebuild(Handler *handler, CellLayout layout) {
+	Grid *grid = &handler->grid;
+	uint8_t type = grid->type;
+	uint8_t cell_cap = grid->cell_cap;
+
+	GridClose(grid);
+	GridInit(grid, type, layout, cell_cap);
+
+	for(INT_N i = 0; i < handler->entity_count; i++) {
+		comp_Transform *transform = HandlerGetComponent(handler, i, COMP_TRANSFORM);
+		if(transform) GridInsert(grid, i, transform->position);
+	}
+}
+
+static void GridTuneReport(Handler *handler) {
+	Grid *grid = &handler->grid;
+	GridTuning *tuning = &handler->grid_tuning;
+
+	ProfileValue(PROF_GRID_CELL_SIZE, grid->layout.cell_size.x);
+	ProfileValue(PROF_GRID_COLS, grid->layout.cols);
+	ProfileValue(PROF_GRID_ROWS, grid->layout.rows);
+	ProfileValue(PROF_GRID_OCCUPIED, tuning->occupied_cells);
+	ProfileValue(PROF_GRID_PEAK, tuning->peak_entries);
+	ProfileValue(PROF_GRID_QUERY_COST, tuning->query_cost);
+	ProfileValue(PROF_GRID_RETUNES, tuning->retunes);
+}
+
+void HandlerFitGrid(Handler *handler, Rectangle bounds) {
+	GridTuning *tuning = &handler->grid_tuning;
+
+	bounds.x += tuning->offset.x;
+	bounds.y += tuning->offset.y;
+
+	tuning->bounds = bounds;
+	tuning->next_tick = handler->tick + GRID_TUNE_INTERVAL;
+
+	CellLayout layout = CellLayoutFit(bounds, tuning->cell_size);
+
+	// Sparse grid keeps configured cell size whatever the bounds
+	CellLayout grid_layout = (tuning->type == GRID_SPARSE) ? GridSparseLayout(layout.origin, tuning->cell_size) : layout;
+
+	// Replay runs on the grid it was recorded with, whatever options and level say now
+	if(tuning->pinned) {
+		tuning->type = tuning->pinned_type;
+		tuning->cell_size = tuning->pinned_grid.cell_size.x;
+		grid_layout = tuning->pinned_grid;
+		layout = tuning->pinned_level;
+	}
+
+	handler->grid.cell_cap = tuning->cell_cap;
+	handler->grid.type = tuning->type;
+	GridRebuild(handler, grid_layout);
+
+	// Fog of war keeps this layout for the level, sources restamp into it
+	Visibility *vis = &handler->visibility;
+	VisibilityClose(vis);
+	VisibilityInit(vis, layout);
+
+	for(INT_N i = 0; i < handler->entity_count; i++) {
+		comp_Vision *vision = HandlerGetComponent(handler, i, COMP_VISION);
+		comp_Transform *transform = HandlerGetComponent(handler, i, COMP_TRANSFORM);
+		if(!vision || !transform) continue;
+
+		vision->cell = VisibilityCell(vis, transform->position);
+		vision->cells = VisibilityRadiusCells(vis, vision->radius);
+		VisibilityStamp(vis, vision->cell, vision->cells, 1);
+	}
+
+	if(tuning->type == GRID_SPARSE) 
+		printf("grid: sparse, cells of %.0f from %.0f, %.0f, fog %dx%d\n", tuning->cell_size, layout.origin.x, layout.origin.y, layout.cols, layout.rows);
+	else 
+		printf("grid: %dx%d cells of %.0f from %.0f, %.0f\n", layout.cols, layout.rows, layout.cell_size.x, layout.origin.x, layout.origin.y);
+
+	GridTuneReport(handler);
+}
+
+// *
+// Predicted work per query of side 'extent' with cells of side 'size'
+//
+// A query visits (extent / size + 1)^2 cells on average and tests every entry in them,
+// which covers an area of about (extent + size)^2 at the density queries see.
+// *
+static float GridTuneCost(float extent, float density, float size) {
+	float span = extent / size + 1;
+	float area = (extent + size) * (extent + size);
+
+	return GRID_TUNE_CELL_COST * span * span + GRID_TUNE_ENTRY_COST * density * area;
+}
+
+void GridTuneUpdate(Handler *handler) {
+	GridTuning *tuning = &handler->grid_tuning;
+	Grid *grid = &handler->grid;
+
+	// Settings changed while running, rebuild over fitted area, fog of war keeps the level layout
+	if(tuning->refit) {
+		tuning->refit = false;
+
+		grid->cell_cap = tuning->cell_cap;
+		GridRebuild(handler, (grid->type == GRID_SPARSE) ? GridSparseLayout(grid->layout.origin, tuning->cell_size) : CellLayoutFit(tuning->bounds, tuning->cell_size));
+
+		printf("grid: rebuilt with cells of %.0f, %d entities each\n", grid->layout.cell_size.x, grid->cell_cap);
+		GridTuneReport(handler);
+	}
+
+	if(!tuning->auto_tune || handler->tick < tuning->next_tick) return;
+
+	tuning->next_tick = handler->tick + GRID_TUNE_INTERVAL;
+
+	GridStats stats = grid->stats;
+	grid->stats = (GridStats) { 0 };
+
+	// Entity density: occupied cells and the fullest one, pooled cells not in use are empty
+	tuning->occupied_cells = 0;
+	tuning->peak_entries = 0;
+
+	for(uint16_t i = 0; i < grid->cell_count; i++) {
+		INT_N count = grid->cells[i].entity_count;
+
+		tuning->occupied_cells += (count > 0);
+		if(count > tuning->peak_entries) tuning->peak_entries = count;
+	}
+
+	if(stats.queries < GRID_TUNE_MIN_QUERIES) {
+		GridTuneReport(handler);
+		return;
+	}
+
+	// Average query side, and entries per unit area around queries as tested at current size
+	float size = grid->layout.cell_size.x;
+	float extent = stats.extent / stats.queries;
+	float density = stats.entries / (stats.queries * (extent + size) * (extent + size));
+
+	float current = GridTuneCost(extent, density, size);
+
+	CellLayout best = grid->layout;
+	float best_cost = current;
+
+	for(float candidate = GRID_TUNE_MIN_SIZE; candidate <= GRID_TUNE_MAX_SIZE; candidate *= GRID_TUNE_STEP) {
+		CellLayout layout = (grid->type == GRID_SPARSE) ? GridSparseLayout(grid->layout.origin, candidate) : CellLayoutFit(tuning->bounds, candidate);
+
+		// Larger cells hold more, fullest cell has to keep fitting
+		float growth = (layout.cell_size.x * layout.cell_size.y) / (grid->layout.cell_size.x * grid->layout.cell_size.y);
+		if(growth > 1 && tuning->peak_entries * growth > grid->cell_cap * GRID_TUNE_FILL) continue;
+
+		float cost = GridTuneCost(extent, density, layout.cell_size.x);
+
+		if(cost < best_cost) {
+			best = layout;
+			best_cost = cost;
+		}
+	}
+
+	tuning->query_cost = current;
+
+	if(best_cost < current * GRID_TUNE_GAIN) {
+		if(grid->type == GRID_SPARSE) 
+			printf("grid: retuned sparse cell size %.0f -> %.0f, query cost %.1f -> %.1f\n", size, best.cell_size.x, current, best_cost);
+		else 
+			printf("grid: retuned cell size %.0f -> %.0f (%dx%d), query cost %.1f -> %.1f\n",
+				size, best.cell_size.x, best.cols, best.rows, current, best_cost);
+
+		GridRebuild(handler, best);
+
+		tuning->query_cost = best_cost;
+		tuning->retunes++;
+	}
+
+	GridTuneReport(handler);
+}
@@ -1,97 +1,617 @@
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <float.h>
 #include "raylib.h"
 #include "raymath.h"
 #include "handler.h"
+#include "prefabs.h"
 #include "game.h"
 #include "kmath.h"
+#include "memory.h"
 
 // Declare component pools
-declare_component_pool(transforms, comp_Transform);
-declare_component_pool(sprites, comp_Sprite);
-declare_component_pool(selectables, comp_Selectable);
-
-char *comp_names[COMP_TYPE_COUNT] = {
-	"transform	",
-	"sprite	",
-	"selectable	"
+#define comp_declare_pool(_id, _field, _pool, _type) declare_component_pool(_pool, _type);
+COMPONENT_LIST(comp_declare_pool)
+
+ComponentType component_types[COMP_REGISTERED_COUNT] = {
+	COMPONENT_LIST(comp_type_entry)
 };
 
-void HandlerInit(Handler *handler, Camera2D *camera, float dt) {
+// Compile-time checks on registered components, fails with negative array size
+// Sizes go in snapshot layout bytes and pools are plain calloc'd arrays
+#define comp_static_assert(_cond, _tag) typedef char _tag[(_cond) ? 1 : -1]
+#define comp_check(_id, _field, _pool, _type)																\
+	comp_static_assert(sizeof(_type) <= COMP_MAX_SIZE, comp_size_check_##_field);							\
+	comp_static_assert(offsetof(struct { char c; _type t; }, t) <= COMP_MAX_ALIGN, comp_align_check_##_field);
+
+COMPONENT_LIST(comp_check)
+comp_static_assert(COMP_REGISTERED_COUNT <= COMP_TYPE_COUNT, comp_count_check);
+
+// Free slots and owners aren't stored in snapshots, anything not used by a live entity is free
+static void HandlerRebuildFreeSlots(Handler *handler) {
+	for(uint32_t i = 0; i < COMP_REGISTERED_COUNT; i++) 
+		component_types[i].mark_all_free();
+
+	memset(handler->free_entities, 0, sizeof(uint64_t) * SLOT_WORDS(ENTITY_CAP));
+	handler->free_entity_count = 0;
+
+	for(INT_N i = 0; i < handler->entity_count; i++) {
+		Entity *entity = &handler->entities[i];
+
+		if(!entity->components) {
+			slot_set(handler->free_entities, i);
+			handler->free_entity_count++;
+			continue;
+		}
+
+		for(uint32_t bits = entity->components; bits; bits &= bits - 1) {
+			uint32_t i = __builtin_ctz(bits);
+			INT_N comp_id = entity->comp_map.component_id[i];
+
+			component_types[i].claim(comp_id);
+			(*component_types[i].owners)[comp_id] = entity->id;
+		}
+	}
+}
+
+// Vision counts aren't stored in snapshots, restamp every source where it was
+static void HandlerRebuildVisibility(Handler *handler) {
+	VisibilityClear(&handler->visibility);
+
+	for(INT_N i = 0; i < handler->entity_count; i++) {
+		comp_Vision *vision = HandlerGetComponent(handler, i, COMP_VISION);
+		if(vision) VisibilityStamp(&handler->visibility, vision->cell, vision->cells, 1);
+	}
+}
+
+void HandlerInit(Handler *handler, Arena *arena, uint64_t seed) {
 	// Initialize component pools
-	_pool_transforms_init();
-	_pool_sprites_init();
-	_pool_selectables_init();
+	for(uint32_t i = 0; i < COMP_REGISTERED_COUNT; i++) 
+		component_types[i].init();
 
 	// Allocate memory for entities
 	handler->entity_count = 0;
-	handler->entities = calloc(ENTITY_CAP, sizeof(Entity));
-	handler->comp_mappings = calloc(ENTITY_CAP, sizeof(ComponentMap));
-
-	// Set camera pointer
-	handler->camera = camera;
-
-	// Initialize spatial grid
-	GridInit(&handler->grid, (Vector2){96, 96}, 128, 128);	
-
-	for(int i = 0; i < 30; i++) { 
-		SpawnEntity( 
-			handler, (comp_Transform) { 
-				.position = (Vector2){ (128) + (i * 100), 300},
-				.velocity = (Vector2){ 0, 0 },
-				.scale = 1, 
-				.rotation = 0 
-			}
-		);
-		
-		PrintComponentMappings(handler, i);
-	}
+	handler->entities = TrackedCalloc(ENTITY_CAP, sizeof(Entity));
+	handler->comp_mappings = TrackedCalloc(ENTITY_CAP, sizeof(ComponentMap));
+	handler->free_entities = TrackedCalloc(SLOT_WORDS(ENTITY_CAP), sizeof(uint64_t));
+	handler->free_entity_count = 0;
+
+	// Allocate shared order queue ring pool
+	handler->order_queues = TrackedCalloc(COMP_CAP * ORDER_QUEUE_CAP, sizeof(Order));
+
+	ProjectilesInit(&handler->projectiles, PROJECTILE_CAP);
+
+	handler->effect_count = 0;
+
+	// Waves and static layer are filled in by level loading
+	WavesInit(&handler->waves);
+	StaticLayerInit(&handler->statics);
+
+	// Set arena pointer
+	handler->arena = arena;
+
+	// Reset simulation clock and random number generator
+	handler->tick = 0;
+	RngSeed(&handler->rng, seed);
+
+	// Default grid until a level fits it to its bounds
+	CellLayout layout = (CellLayout) {
+		.cell_size = (Vector2) { GRID_DEFAULT_CELL_SIZE, GRID_DEFAULT_CELL_SIZE },
+		.cols = GRID_DEFAULT_COLS,
+		.rows = GRID_DEFAULT_ROWS
+	};
+
+	handler->grid_tuning = (GridTuning) {
+		.cell_size = GRID_DEFAULT_CELL_SIZE,
+		.cell_cap = GRID_DEFAULT_CELL_CAP,
+		.bounds = CellLayoutBounds(&layout)
+	};
+
+	GridInit(&handler->grid, GRID_DENSE, layout, GRID_DEFAULT_CELL_CAP);
+	VisibilityInit(&handler->visibility, layout);
+	SelectionInit(&handler->selection);
+
+	// Starting fleet
+	Vector2 positions[30];
+	for(int i = 0; i < 30; i++) 
+		positions[i] = (Vector2){ (128) + (i * 100), 300 };
+
+	SpawnBatch(handler, &prefabs[PREFAB_FIGHTER], 30, positions, NULL);
 }
 
 // Free allocated memory 
 void HandlerClose(Handler *handler) {
 	// Unload entities
-	free(handler->entities);
+	TrackedFree(handler->entities);
+	TrackedFree(handler->comp_mappings);
+	TrackedFree(handler->free_entities);
+	WavesClose(&handler->waves);
+	StaticLayerClose(&handler->statics);
+	TrackedFree(handler->order_queues);
+	ProjectilesClose(&handler->projectiles);
 	GridClose(&handler->grid);
+	VisibilityClose(&handler->visibility);
+	SelectionClose(&handler->selection);
 
 	// Unload component pools
-	_pool_transforms_free();
-	_pool_sprites_free();
-	_pool_selectables_free();
+	for(uint32_t i = 0; i < COMP_REGISTERED_COUNT; i++) 
+		component_types[i].free();
 }
 
 void HandlerUpdate(Handler *handler, float dt) {
+	// Bring grid up to date first, systems below query it
+	// Grid consumes all changes since last tick, including spawns in between ticks
+	GridUpdate(&handler->grid, handler);
+	GridTuneUpdate(handler);
+	VisionUpdate(handler);
+
+	// Changes made below are kept until next tick, for systems running after the update
+	HandlerClearChanges(handler);
+
+	WavesUpdate(handler, dt);
+	OrdersUpdate(handler, dt);
+	SteeringUpdate(handler, dt);
+	TurretsUpdate(handler, dt);
+	ProjectilesUpdate(handler, dt);
 	TransformsUpdate(handler, dt);
 }
 
-void HandlerDraw(Handler *handler) {
-	//DrawText(TextFormat("entity_count: %d", handler->entity_count), 100, 100, 30, RAYWHITE);
+void HandlerClearChanges(Handler *handler) {
+	for(uint32_t i = 0; i < COMP_REGISTERED_COUNT; i++) 
+		component_types[i].clear_dirty();
+}
+
+void HandlerMarkAllChanged(Handler *handler) {
+	for(uint32_t i = 0; i < COMP_REGISTERED_COUNT; i++) 
+		component_types[i].mark_all_dirty();
+
+	handler->change_epoch++;
+}
+
+// FNV-1a
+static uint32_t HashBytes(uint32_t hash, const void *data, size_t size) {
+	const uint8_t *bytes = data;
+
+	for(size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+uint32_t HandlerChecksum(Handler *handler) {
+	uint32_t hash = 2166136261u;
+
+	hash = HashBytes(hash, &handler->tick, sizeof(handler->tick));
+	hash = HashBytes(hash, &handler->rng.state, sizeof(handler->rng.state));
+	hash = HashBytes(hash, &handler->entity_count, sizeof(handler->entity_count));
+
+	// Transforms have no padding, hash pool directly
+	hash = HashBytes(hash, _pool_transforms.data, sizeof(comp_Transform) * _pool_transforms.count);
+
+	// Hash live orders field by field, skip struct padding
+	for(INT_N i = 0; i < _pool_orders.count; i++) {
+		comp_Orders *orders = &_pool_orders.data[i];
+		hash = HashBytes(hash, &orders->count, sizeof(orders->count));
+
+		for(uint8_t j = 0; j < orders->count; j++) {
+			Order *order = &handler->order_queues[i * ORDER_QUEUE_CAP + (orders->head + j) % ORDER_QUEUE_CAP];
+
+			hash = HashBytes(hash, &order->target, sizeof(order->target));
+			hash = HashBytes(hash, &order->type, sizeof(order->type));
+		}
+	}
+
+	// Health and turret targets, skip struct padding
+	for(INT_N i = 0; i < _pool_healths.count; i++)
+		hash = HashBytes(hash, &_pool_healths.data[i].hp, sizeof(float));
+
+	for(INT_N i = 0; i < _pool_turrets.count; i++)
+		hash = HashBytes(hash, &_pool_turrets.data[i].target, sizeof(INT_N));
+
+	Projectiles *p = &handler->projectiles;
+	hash = HashBytes(hash, &p->count, sizeof(p->count));
+	hash = HashBytes(hash, p->pos_x, sizeof(float) * p->count);
+	hash = HashBytes(hash, p->pos_y, sizeof(float) * p->count);
+
+	return hash;
+}
+
+void HandlerPushEffect(Handler *handler, uint8_t type, Vector2 position) {
+	handler->effects[handler->effect_count++ % RENDER_EFFECT_CAP] = (RenderEffect) {
+		.position = position,
+		.tick = handler->tick,
+		.type = type
+	};
+}
+
+void HandlerCaptureRenderState(Handler *handler, RenderState *state) {
+	Grid *grid = &handler->grid;
+
+	state->item_count = 0;
+	state->line_count = 0;
+	state->emitter_count = 0;
+	state->effect_count = 0;
+	state->tick = handler->tick;
+	state->statics = handler->statics.view;
+
+	state->unit_count = 0;
+	state->enemy_count = 0;
+	state->selected_count = 0;
+
+	state->wave = handler->waves.current;
+	state->wave_count = handler->waves.defs.count;
+	state->wave_timer = handler->waves.timer;
+
+	// Cell arrays follow a dense grid, sparse grids are binned into the level layout
+	state->layout = (grid->type == GRID_DENSE) ? grid->layout : handler->visibility.layout;
+	uint16_t state_cells = state->layout.cols * state->layout.rows;
+
+	// Team bits are gathered per cell while walking entities
+	memset(state->cell_teams, 0, state_cells);
 
-	GridRenderDebugView(&handler->grid, handler);
+	// Set component mask
+	uint32_t mask = (COMP_TRANSFORM | COMP_SPRITE);
 
 	for(INT_N i = 0; i < handler->entity_count; i++) {
 		Entity *ent = &handler->entities[i];
+		if((ent->components & mask) != mask) continue;
 
-		uint32_t mask = (COMP_TRANSFORM | COMP_SPRITE);
-		if(!(ent->components & mask)) continue;
-
-		comp_Transform *transform = _pool_transforms_get(ent->comp_map.component_id[1 >> COMP_TRANSFORM]);
-		comp_Sprite *sprite = _pool_sprites_get(ent->comp_map.component_id[1 >> COMP_SPRITE]);
+		comp_Transform *transform = _pool_transforms_get(ent->comp_map.component_id[comp_index(COMP_TRANSFORM)]);
+		comp_Sprite *sprite = _pool_sprites_get(ent->comp_map.component_id[comp_index(COMP_SPRITE)]);
+		comp_Health *health = HandlerGetComponent(handler, i, COMP_HEALTH);
 
-		DrawCircleV(transform->position, 10, ColorAlpha(RAYWHITE, 0.5f));
-		DrawCircleLinesV(transform->position, 10, RAYWHITE);
+		// Enemies in fog aren't drawn at all
+		if(health && health->team != VISION_TEAM && !VisibilityAt(&handler->visibility, transform->position)) continue;
 
-		if(ent->components & COMP_SELECTABLE) {
-			comp_Selectable *selectable = _pool_selectables_get(ent->comp_map.component_id[1 >> COMP_SELECTABLE]);
+		if(health) {
+			if(health->team == VISION_TEAM) state->unit_count++;
+			else state->enemy_count++;
+		}
 
-			if(selectable->flags & SELECTED) {
-				DrawCircleLinesV(transform->position, 10, SKYBLUE);
+		RenderItem item = (RenderItem) {
+			.prev_position = transform->prev_position,
+			.position = transform->position,
+			.sprite_id = sprite->sprite_id,
+			.frame = sprite->frame,
+			.flags = 0
+		};
+
+		// Selected units also show their queued waypoints
+		comp_Selectable *selectable = HandlerGetComponent(handler, i, COMP_SELECTABLE);
+
+		if(selectable && (selectable->flags & SELECTED)) {
+			item.flags |= RENDER_SELECTED;
+			state->selected_count++;
+
+			if(ent->components & COMP_ORDERS) {
+				INT_N orders_id = ent->comp_map.component_id[comp_index(COMP_ORDERS)];
+				comp_Orders *orders = _pool_orders_get(orders_id);
+				Order *ring = &handler->order_queues[orders_id * ORDER_QUEUE_CAP];
+
+				Vector2 from = transform->position;
+				for(uint8_t j = 0; j < orders->count && state->line_count < state->line_capacity; j++) {
+					Order *order = &ring[(orders->head + j) % ORDER_QUEUE_CAP];
+					if(order->type == ORDER_HOLD) break;
+
+					state->lines[state->line_count++] = (RenderLine) { from, order->target };
+					from = order->target;
+				}
 			}
 		}
+
+		if(state->item_count < state->item_capacity)
+			state->items[state->item_count++] = item;
+
+		// Team presence for minimap
+		int32_t cell = CellOf(&state->layout, transform->position);
+
+		if(cell >= 0) {
+			uint8_t team = (health && health->team < 7) ? (1 << health->team) : RENDER_TEAM_NEUTRAL;
+
+			state->cell_teams[cell] |= team;
+		}
+
+		comp_Emitter *emitter = HandlerGetComponent(handler, i, COMP_EMITTER);
+
+		if(emitter && state->emitter_count < state->emitter_capacity) {
+			state->emitters[state->emitter_count++] = (RenderEmitter) {
+				.position = transform->position,
+				.velocity = transform->velocity,
+				.rate = emitter->rate,
+				.type = emitter->type
+			};
+		}
+	}
+
+	// Effects from the last few ticks, newest first
+	uint32_t effects_kept = (handler->effect_count < RENDER_EFFECT_CAP) ? handler->effect_count : RENDER_EFFECT_CAP;
+
+	for(uint32_t i = 0; i < effects_kept; i++) {
+		RenderEffect *effect = &handler->effects[(handler->effect_count - 1 - i) % RENDER_EFFECT_CAP];
+		if(effect->tick + RENDER_EFFECT_TICKS < handler->tick) break;
+
+		state->effects[state->effect_count++] = *effect;
+	}
+
+	// Projectiles
+	Projectiles *p = &handler->projectiles;
+	state->projectile_count = (p->count < state->projectile_capacity) ? p->count : state->projectile_capacity;
+
+	for(uint32_t i = 0; i < state->projectile_count; i++) {
+		state->projectiles[i] = (RenderProjectile) {
+			.position = (Vector2) { p->pos_x[i], p->pos_y[i] },
+			.velocity = (Vector2) { p->vel_x[i], p->vel_y[i] }
+		};
+	}
+
+	// Grid cell counts, sparse cells add up in the level cell holding their center
+	if(grid->type == GRID_DENSE) {
+		for(uint16_t i = 0; i < grid->cell_count; i++) 
+			state->cell_counts[i] = grid->cells[i].entity_count;
+
+	} else {
+		memset(state->cell_counts, 0, state_cells * sizeof(int16_t));
+
+		for(uint16_t i = 0; i < grid->cell_count; i++) {
+			GridCell *cell = &grid->cells[i];
+			if(!cell->entity_count) continue;
+
+			Vector2 center = Vector2Add(CellCorner(&grid->layout, cell->col, cell->row), Vector2Scale(grid->layout.cell_size, 0.5f));
+			int32_t id = CellOf(&state->layout, center);
+
+			if(id >= 0) state->cell_counts[id] += cell->entity_count;
+		}
+	}
+
+	// Fog of war, cells of the level layout
+	Visibility *vis = &handler->visibility;
+	state->vision_layout = vis->layout;
+
+	for(uint32_t i = 0; i < vis->cell_count; i++) 
+		state->cell_vision[i] = VisibilityCellState(vis, i);
+}
+
+// Copy to/from blob, advance blob pointer
+#define snapshot_put(_dst, _src, _size) { memcpy((_dst), (_src), (_size)); (_dst) += (_size); }
+#define snapshot_get(_dst, _src, _size) { memcpy((_dst), (_src), (_size)); (_src) += (_size); }
+
+static SnapshotHeader SnapshotMakeHeader(Handler *handler) {
+	SnapshotHeader header = (SnapshotHeader) {
+		.magic = SNAPSHOT_MAGIC,
+		.version = SNAPSHOT_VERSION,
+		.size = HandlerSnapshotSize(handler),
+		.tick = handler->tick,
+		.rng_state = handler->rng.state,
+		.grid_layout = handler->grid.layout,
+		.vision_layout = handler->visibility.layout,
+		.grid_cell_cap = handler->grid.cell_cap,
+		.grid_type = handler->grid.type,
+		.grid_cells = (handler->grid.type == GRID_DENSE) ? handler->grid.cell_count : handler->grid.occupied,
+		.entity_count = handler->entity_count,
+		.projectile_count = handler->projectiles.count,
+		.wave_timer = handler->waves.timer,
+		.wave_current = handler->waves.current,
+		.wave_spawned = handler->waves.spawned,
+		.wave_count = handler->waves.count
+	};
+
+	header.layout[0] = sizeof(Entity);
+	header.layout[1] = sizeof(Order);
+
+	for(uint32_t i = 0; i < COMP_REGISTERED_COUNT; i++) {
+		header.layout[i + 2] = component_types[i].size;
+		header.component_counts[i] = *component_types[i].count;
+	}
+
+	return header;
+}
+
+size_t HandlerSnapshotSize(Handler *handler) {
+	Grid *grid = &handler->grid;
+
+	size_t size = sizeof(SnapshotHeader);
+	size += sizeof(Entity) * handler->entity_count;
+	size += sizeof(Order) * ORDER_QUEUE_CAP * _pool_orders.count;
+
+	for(uint32_t i = 0; i < COMP_REGISTERED_COUNT; i++) 
+		size += component_types[i].size * *component_types[i].count;
+
+	size += PROJECTILE_SIZE * handler->projectiles.count;
+
+	// Grid cells store only occupied entries, sparse grids only occupied cells with their coordinates
+	if(grid->type == GRID_SPARSE) 
+		size += (sizeof(int32_t) * 2 + sizeof(INT_N)) * grid->occupied;
+	else 
+		size += sizeof(INT_N) * grid->cell_count;
+
+	for(uint16_t i = 0; i < grid->cell_count; i++) 
+		size += sizeof(INT_N) * grid->cells[i].entity_count;
+
+	return size;
+}
+
+void HandlerSnapshotWrite(Handler *handler, uint8_t *dst) {
+	Grid *grid = &handler->grid;
+	SnapshotHeader header = SnapshotMakeHeader(handler);
+
+	snapshot_put(dst, &header, sizeof(header));
+	snapshot_put(dst, handler->entities, sizeof(Entity) * handler->entity_count);
+
+	// Component pools
+	for(uint32_t i = 0; i < COMP_REGISTERED_COUNT; i++) 
+		snapshot_put(dst, component_types[i].ref(0), component_types[i].size * *component_types[i].count);
+
+	snapshot_put(dst, handler->order_queues, sizeof(Order) * ORDER_QUEUE_CAP * _pool_orders.count);
+	dst += ProjectilesWrite(&handler->projectiles, dst);
+
+	// Sparse cell coordinates, pooled cells not in use are left out here and below
+	bool sparse = (grid->type == GRID_SPARSE);
+
+	for(uint16_t i = 0; sparse && i < grid->cell_count; i++) {
+		if(!grid->cells[i].entity_count) continue;
+
+		snapshot_put(dst, &grid->cells[i].col, sizeof(int32_t));
+		snapshot_put(dst, &grid->cells[i].row, sizeof(int32_t));
+	}
+
+	// Grid cell counts, then entries
+	for(uint16_t i = 0; i < grid->cell_count; i++)
+		if(!sparse || grid->cells[i].entity_count) snapshot_put(dst, &grid->cells[i].entity_count, sizeof(INT_N));
+
+	for(uint16_t i = 0; i < grid->cell_count; i++)
+		snapshot_put(dst, grid->cells[i].entities, sizeof(INT_N) * grid->cells[i].entity_count);
+}
+
+bool HandlerSnapshotRead(Handler *handler, const uint8_t *src, size_t size) {
+	Grid *grid = &handler->grid;
+
+	// Validate header against this build and grid
+	SnapshotHeader header;
+	if(size < sizeof(header)) return false;
+	memcpy(&header, src, sizeof(header));
+
+	SnapshotHeader expected = SnapshotMakeHeader(handler);
+
+	bool valid = 
+		memcmp(header.magic, SNAPSHOT_MAGIC, 4) == 0 &&
+		header.version == SNAPSHOT_VERSION &&
+		memcmp(header.layout, expected.layout, sizeof(header.layout)) == 0 &&
+		header.size == size &&
+		CellLayoutEqual(&header.vision_layout, &handler->visibility.layout) &&
+		((header.grid_type == GRID_SPARSE && header.grid_cells <= ENTITY_CAP) || (header.grid_type == GRID_DENSE &&
+			header.grid_layout.cols > 0 && header.grid_layout.rows > 0 &&
+			(uint32_t)header.grid_layout.cols * header.grid_layout.rows <= CELLS_MAX &&
+			header.grid_cells == header.grid_layout.cols * header.grid_layout.rows)) &&
+		header.grid_layout.cell_size.x > 0 && header.grid_layout.cell_size.y > 0 &&
+		header.grid_cell_cap > 0 &&
+		header.entity_count <= ENTITY_CAP &&
+		header.projectile_count <= handler->projectiles.capacity;
+
+	for(uint32_t i = 0; valid && i < COMP_REGISTERED_COUNT; i++) 
+		valid = (header.component_counts[i] >= 0 && header.component_counts[i] <= COMP_CAP);
+
+	// Check grid cell counts before touching any state
+	if(valid) {
+		size_t grid_offset = sizeof(header) +
+			sizeof(Entity) * header.entity_count +
+			sizeof(Order) * ORDER_QUEUE_CAP * header.component_counts[CI_ORDERS] +
+			PROJECTILE_SIZE * header.projectile_count;
+
+		for(uint32_t i = 0; i < COMP_REGISTERED_COUNT; i++) 
+			grid_offset += component_types[i].size * header.component_counts[i];
+
+		// Sparse cells are stored only while occupied, coordinates first
+		bool sparse = (header.grid_type == GRID_SPARSE);
+		uint16_t cell_count = header.grid_cells;
+
+		if(sparse) grid_offset += sizeof(int32_t) * 2 * cell_count;
+
+		size_t entries_size = 0;
+		valid = (grid_offset + sizeof(INT_N) * cell_count <= size);
+
+		for(uint16_t i = 0; valid && i < cell_count; i++) {
+			INT_N count;
+			memcpy(&count, src + grid_offset + i * sizeof(INT_N), sizeof(INT_N));
+
+			valid = (count >= sparse && count <= header.grid_cell_cap);
+			entries_size += sizeof(INT_N) * count;
+		}
+
+		valid = valid && (grid_offset + sizeof(INT_N) * cell_count + entries_size == size);
+	}
+
+	if(!valid) {
+		printf("ERROR: Snapshot doesn't match current build or level\n");
+		return false;
 	}
+
+	src += sizeof(header);
+
+	// Grid as it was tuned when saved, sparse cells are pooled again as they're read
+	if(header.grid_type == GRID_SPARSE || grid->type != GRID_DENSE ||
+		!CellLayoutEqual(&header.grid_layout, &grid->layout) || header.grid_cell_cap != grid->cell_cap) {
+
+		GridClose(grid);
+		GridInit(grid, header.grid_type, header.grid_layout, header.grid_cell_cap);
+	}
+
+	// Tuning samples start over from the loaded tick
+	grid->stats = (GridStats) { 0 };
+	handler->grid_tuning.next_tick = header.tick + GRID_TUNE_INTERVAL;
+
+	handler->tick = header.tick;
+	handler->rng.state = header.rng_state;
+
+	handler->waves.timer = header.wave_timer;
+	handler->waves.current = header.wave_current;
+	handler->waves.spawned = header.wave_spawned;
+	handler->waves.count = header.wave_count;
+
+	handler->entity_count = header.entity_count;
+	snapshot_get(handler->entities, src, sizeof(Entity) * header.entity_count);
+
+	// Component pools
+	for(uint32_t i = 0; i < COMP_REGISTERED_COUNT; i++) {
+		*component_types[i].count = header.component_counts[i];
+		snapshot_get(component_types[i].ref(0), src, component_types[i].size * header.component_counts[i]);
+	}
+
+	snapshot_get(handler->order_queues, src, sizeof(Order) * ORDER_QUEUE_CAP * header.component_counts[CI_ORDERS]);
+	src += ProjectilesRead(&handler->projectiles, src, header.projectile_count);
+
+	if(grid->type == GRID_SPARSE) {
+		// Coordinates, then counts, then entries of each stored cell
+		const uint8_t *coords = src;
+		const uint8_t *counts = coords + sizeof(int32_t) * 2 * header.grid_cells;
+		src = counts + sizeof(INT_N) * header.grid_cells;
+
+		for(uint16_t i = 0; i < header.grid_cells; i++) {
+			int32_t key[2];
+			snapshot_get(key, coords, sizeof(key));
+
+			GridCell *cell = GridSparseAcquire(grid, key[0], key[1]);
+			snapshot_get(&cell->entity_count, counts, sizeof(INT_N));
+			snapshot_get(cell->entities, src, sizeof(INT_N) * cell->entity_count);
+		}
+
+	} else {
+		// Grid cell counts, then entries
+		for(uint16_t i = 0; i < grid->cell_count; i++)
+			snapshot_get(&grid->cells[i].entity_count, src, sizeof(INT_N));
+
+		for(uint16_t i = 0; i < grid->cell_count; i++)
+			snapshot_get(grid->cells[i].entities, src, sizeof(INT_N) * grid->cells[i].entity_count);
+	}
+
+	HandlerRebuildFreeSlots(handler);
+	HandlerRebuildVisibility(handler);
+	SelectionRebuild(handler);
+
+	// Everything may differ from before, incremental systems start over
+	HandlerMarkAllChanged(handler);
+
+	return true;
+}
+
+INT_N HandlerSpawnCapacity(Handler *handler, uint32_t components) {
+	INT_N capacity = (ENTITY_CAP - handler->entity_count) + handler->free_entity_count;
+
+	for(uint32_t bits = components; bits; bits &= bits - 1) {
+		INT_N available = component_types[__builtin_ctz(bits)].available();
+		if(available < capacity) capacity = available;
+	}
+
+	return capacity;
+}
+
+bool HandlerCanSpawn(Handler *handler, uint32_t components, INT_N count) {
+	return HandlerSpawnCapacity(handler, components) >= count;
 }
 
 INT_N AddEntity(Handler *handler, uint32_t components) {
@@ -100,26 +620,23 @@ INT_N AddEntity(Handler *handler, uint32_t components) {
 	INT_N mappings[COMP_TYPE_COUNT] = { 0 };
 	memset(mappings, COMP_NULL, sizeof(mappings));
 
-	// Create new components and register their IDs to the mapping  
-	for(uint32_t i = 0; i < COMP_TYPE_COUNT; i++) {
-		uint32_t mask = (1 << i);
-
-		if(!(components & mask)) continue; 
+	// Reuse id of a killed entity if there is one
+	INT_N id = (handler->free_entity_count) ? SlotsTakeLowest(handler->free_entities, SLOT_WORDS(ENTITY_CAP)) : -1;
 
-		switch(mask) {
-			printf("adding %s component...\n", comp_names[i]);
+	if(id >= 0) handler->free_entity_count--;
+	else id = handler->entity_count++;
 
-			case COMP_TRANSFORM:	_pool_transforms_bind_to(mappings, i);	break;
-			case COMP_SPRITE:		_pool_sprites_bind_to(mappings, i);		break;
-			case COMP_SELECTABLE:	_pool_selectables_bind_to(mappings, i);	break;
-		}
+	// Create new components and register their IDs to the mapping, set bits only
+	for(uint32_t bits = components; bits; bits &= bits - 1) {
+		uint32_t i = __builtin_ctz(bits);
+		component_types[i].bind_to(mappings, i, id);
 	}
-	
+
 	// Initialize entity struct 
 	Entity new_entity = (Entity) {
-		new_entity.components = components,
-		new_entity.id = handler->entity_count++,
-		new_entity.flags = 0
+		.components = components,
+		.id = id,
+		.flags = 0
 	};
 
 	// Copy component mappings
@@ -132,46 +649,683 @@ INT_N AddEntity(Handler *handler, uint32_t components) {
 	return new_entity.id;
 }
 
-// Create a new entity 
-// Make, bind and map specified transform component 
-void SpawnEntity(Handler *handler, comp_Transform transform) {
-	// Initialize entity, insert to entity array
-	INT_N id = AddEntity(handler, (COMP_TRANSFORM | COMP_SPRITE | COMP_SELECTABLE));
+INT_N AddEntityBatch(Handler *handler, uint32_t components, const void **defaults, INT_N count, INT_N *ids) {
+	INT_N capacity = HandlerSpawnCapacity(handler, components);
+	if(count > capacity) count = capacity;
+
+	// Take ids, killed entities first
+	for(INT_N k = 0; k < count; k++) {
+		INT_N id = (handler->free_entity_count) ? SlotsTakeLowest(handler->free_entities, SLOT_WORDS(ENTITY_CAP)) : -1;
+
+		if(id >= 0) handler->free_entity_count--;
+		else id = handler->entity_count++;
+
+		Entity *entity = &handler->entities[id];
+		*entity = (Entity) {
+			.components = components,
+			.id = id,
+			.flags = 0
+		};
+
+		memset(entity->comp_map.component_id, COMP_NULL, sizeof(entity->comp_map.component_id));
+		ids[k] = id;
+	}
+
+	// Fill one pool at a time
+	for(uint32_t bits = components; bits; bits &= bits - 1) {
+		uint32_t i = __builtin_ctz(bits);
+		component_types[i].bind_batch(handler->entities, ids, count, i, defaults[i]);
+	}
+
+	return count;
+}
+
+void KillEntity(Handler *handler, INT_N entity_id) {
+	Entity *entity = &handler->entities[entity_id];
+	Grid *grid = &handler->grid;
+
+	// Already dead
+	if(!entity->components) return;
+
+	// Entity sits in the cell of its position at last grid update
+	comp_Transform *transform = HandlerGetComponent(handler, entity_id, COMP_TRANSFORM);
+
+	if(transform) {
+		GridRemove(grid, entity_id, transform->position);
+
+		HandlerPushEffect(handler, EFFECT_EXPLOSION, transform->position);
+	}
+
+	// Stop revealing its area
+	comp_Vision *vision = HandlerGetComponent(handler, entity_id, COMP_VISION);
+	if(vision) VisibilityStamp(&handler->visibility, vision->cell, vision->cells, -1);
 
-	// Get pointer to newly created entity 
-	Entity *spawned_entity = &handler->entities[id];
+	SelectionForget(handler, entity_id);
 
-	// Get transform component index from entity's component mappings
-	INT_N transform_component_id = spawned_entity->comp_map.component_id[COMP_TRANSFORM >> 1];
+	// Release components and id
+	for(uint32_t bits = entity->components; bits; bits &= bits - 1) {
+		uint32_t i = __builtin_ctz(bits);
+		component_types[i].release(entity->comp_map.component_id[i]);
+	}
 
-	// Get pointer to newly created entity 
-	comp_Transform *pTransform = &_pool_transforms.data[transform_component_id];
+	// Systems skip entities without components
+	entity->components = 0;
 
-	// Copy transform data 
-	memcpy(pTransform, &transform, sizeof(comp_Transform));
+	slot_set(handler->free_entities, entity_id);
+	handler->free_entity_count++;
 }
 
 void TransformsUpdate(Handler *handler, float dt) {
-	float time = GetTime(); 
-
-	GridUpdate(&handler->grid, handler);
-	
 	for(INT_N i = 0; i < _pool_transforms.count; i++) {
 		comp_Transform *transform = &_pool_transforms.data[i];
 
 		transform->prev_position = transform->position;
-		transform->position.y = 100 * sin(i + time * (1.5f)) + 420;
-		//transform->position.y += sin(i + time * (1));
+
+		// Resting entities stay clean, grid and other incremental systems skip them
+		if(transform->velocity.x == 0 && transform->velocity.y == 0) continue;
+
+		transform->position = Vector2Add(transform->position, Vector2Scale(transform->velocity, dt));
+		_pool_transforms_mark_dirty(i);
+	}
+}
+
+void OrdersUpdate(Handler *handler, float dt) {
+	if(dt <= 0) return;
+
+	// Set component mask
+	uint32_t mask = (COMP_TRANSFORM | COMP_ORDERS);
+
+	for(INT_N i = 0; i < handler->entity_count; i++) {
+		Entity *entity = &handler->entities[i];
+
+		// Skip entities that don't have required components
+		if((entity->components & mask) != mask) continue;
+
+		comp_Transform *transform = _pool_transforms_get(entity->comp_map.component_id[comp_index(COMP_TRANSFORM)]);
+		comp_Steering *steering = HandlerGetComponent(handler, i, COMP_STEERING);
+		INT_N orders_id = entity->comp_map.component_id[comp_index(COMP_ORDERS)];
+
+		// Stop if there's nothing to do, or holding position
+		Order *order = OrdersFront(handler, orders_id);
+		if(!order || order->type == ORDER_HOLD) {
+			if(steering) steering->flags &= ~STEER_ACTIVE;
+			else transform->velocity = Vector2Zero();
+
+			continue;
+		}
+
+		Vector2 to_target = Vector2Subtract(order->target, transform->position);
+		float dist = Vector2Length(to_target);
+		float step = UNIT_SPEED * dt;
+
+		bool arrived;
+
+		if(steering) {
+			// New target, forget previous arrival
+			if(!Vector2Equals(steering->target, order->target)) {
+				steering->target = order->target;
+				steering->flags &= ~STEER_ARRIVED;
+			}
+
+			// Units in a crowd can't all reach the exact point,
+			// steering marks them arrived once they touch one that did
+			arrived = (dist <= STEER_ARRIVE_DIST) || (steering->flags & STEER_ARRIVED);
+
+			if(arrived) steering->flags = (steering->flags & ~STEER_ACTIVE) | STEER_ARRIVED;
+			else steering->flags |= STEER_ACTIVE;
+		} else {
+			arrived = (dist <= step);
+
+			// Keep moving towards target, or arrive exactly on target this frame
+			if(arrived) transform->velocity = Vector2Scale(to_target, 1.0f / dt);
+			else transform->velocity = Vector2Scale(to_target, UNIT_SPEED / dist);
+		}
+
+		if(!arrived) continue;
+
+		// Patrol orders go back to the end of the queue, reversed
+		Order done = *order;
+		OrdersPop(handler, orders_id);
+
+		if(done.type == ORDER_PATROL) {
+			OrdersPush(handler, orders_id, (Order) {
+				.target = done.origin,
+				.origin = done.target,
+				.type = ORDER_PATROL
+			});
+		}
+	}
+}
+
+// Push away from an obstacle if current heading runs into it, zero if clear
+static Vector2 SteerAvoid(Vector2 pos, Vector2 vel, Vector2 obstacle, float radius) {
+	Vector2 to_obstacle = Vector2Subtract(obstacle, pos);
+
+	// Closest point to obstacle along the next 'STEER_LOOKAHEAD' seconds of movement
+	float speed_sq = Vector2LengthSqr(vel);
+	float t = (speed_sq > 0) ? Clamp(Vector2DotProduct(to_obstacle, vel) / speed_sq, 0, STEER_LOOKAHEAD) : 0;
+
+	Vector2 away = Vector2Subtract(Vector2Add(pos, Vector2Scale(vel, t)), obstacle);
+	float clearance = radius + STEER_UNIT_RADIUS;
+	float dist = Vector2Length(away);
+
+	if(dist >= clearance) return Vector2Zero();
+
+	// Heading straight at the center, sidestep instead
+	if(dist < 0.001f) away = (Vector2) { -vel.y, vel.x };
+
+	return Vector2Scale(Vector2Normalize(away), 1.0f - dist / clearance);
+}
+
+void SteeringUpdate(Handler *handler, float dt) {
+	if(dt <= 0) return;
+
+	Grid *grid = &handler->grid;
+	Arena *arena = handler->arena;
+
+	// Set component mask
+	uint32_t mask = (COMP_TRANSFORM | COMP_STEERING);
+
+	// *
+	// Gather steering units into flat arrays, so the force pass below
+	// reads contiguous memory and every unit only writes its own slot
+	// 'slots' maps entity id to array index, -1 if entity doesn't steer
+	// *
+	INT_N *slots = ArenaPushArray(arena, INT_N, handler->entity_count);
+	INT_N *ids = ArenaPushArray(arena, INT_N, handler->entity_count);
+
+	float *px = ArenaPushArray(arena, float, handler->entity_count);
+	float *py = ArenaPushArray(arena, float, handler->entity_count);
+	float *vx = ArenaPushArray(arena, float, handler->entity_count);
+	float *vy = ArenaPushArray(arena, float, handler->entity_count);
+	float *fx = ArenaPushArray(arena, float, handler->entity_count);
+	float *fy = ArenaPushArray(arena, float, handler->entity_count);
+	comp_Steering **steerings = ArenaPushArray(arena, comp_Steering*, handler->entity_count);
+	uint8_t *arrived = ArenaPushArray(arena, uint8_t, handler->entity_count);
+
+	INT_N count = 0;
+
+	for(INT_N i = 0; i < handler->entity_count; i++) {
+		Entity *entity = &handler->entities[i];
+		slots[i] = -1;
+
+		if((entity->components & mask) != mask) continue;
+
+		comp_Transform *transform = _pool_transforms_get(entity->comp_map.component_id[comp_index(COMP_TRANSFORM)]);
+
+		px[count] = transform->position.x;
+		py[count] = transform->position.y;
+		vx[count] = transform->velocity.x;
+		vy[count] = transform->velocity.y;
+		steerings[count] = _pool_steerings_get(entity->comp_map.component_id[comp_index(COMP_STEERING)]);
+		arrived[count] = 0;
+
+		ids[count] = i;
+		slots[i] = count++;
+	}
+
+	// Desired velocity of each unit
+	for(INT_N s = 0; s < count; s++) {
+		comp_Steering *steering = steerings[s];
+		Vector2 pos = (Vector2) { px[s], py[s] };
+		Vector2 vel = (Vector2) { vx[s], vy[s] };
+
+		Vector2 separation = Vector2Zero();
+		Vector2 avoidance = Vector2Zero();
+		Vector2 center = Vector2Zero();
+		uint8_t grouped = 0;
+		uint8_t neighbours = 0;
+
+		// Cells overlapping neighbour radius
+		Rectangle reach = (Rectangle) { pos.x - STEER_NEIGHBOUR_RADIUS, pos.y - STEER_NEIGHBOUR_RADIUS, STEER_NEIGHBOUR_RADIUS * 2, STEER_NEIGHBOUR_RADIUS * 2 };
+
+		int32_t col_start, row_start, col_end, row_end;
+		GridQueryRange(grid, reach, &col_start, &row_start, &col_end, &row_end);
+
+		for(int32_t r = row_start; r <= row_end && neighbours < STEER_MAX_NEIGHBOURS; r++) {
+			for(int32_t c = col_start; c <= col_end && neighbours < STEER_MAX_NEIGHBOURS; c++) {
+				GridCell *cell = GridCellAt(grid, c, r);
+				if(!cell) continue;
+
+				grid->stats.entries += cell->entity_count;
+
+				for(INT_N j = 0; j < cell->entity_count && neighbours < STEER_MAX_NEIGHBOURS; j++) {
+					INT_N other_id = cell->entities[j];
+					INT_N o = slots[other_id];
+
+					if(o == s) continue;
+
+					// Static obstacle, check if current heading runs into it
+					if(o < 0) {
+						comp_Obstacle *obstacle = HandlerGetComponent(handler, other_id, COMP_OBSTACLE);
+						if(!obstacle) continue;
+
+						comp_Transform *obstacle_transform = HandlerGetComponent(handler, other_id, COMP_TRANSFORM);
+						avoidance = Vector2Add(avoidance, SteerAvoid(pos, vel, obstacle_transform->position, obstacle->radius));
+						continue;
+					}
+
+					Vector2 away = Vector2Subtract(pos, (Vector2) { px[o], py[o] });
+					float dist_sq = Vector2LengthSqr(away);
+
+					if(dist_sq > STEER_NEIGHBOUR_RADIUS * STEER_NEIGHBOUR_RADIUS) continue;
+					neighbours++;
+
+					float dist = sqrtf(dist_sq);
+					comp_Steering *other = steerings[o];
+
+					if(dist < STEER_SEPARATION_DIST) {
+						// Stacked exactly, split by slot order so result stays deterministic
+						if(dist < 0.001f) away = (Vector2) { (s < o) ? -1.0f : 1.0f, 0 };
+						else away = Vector2Scale(away, 1.0f / dist);
+
+						separation = Vector2Add(separation, Vector2Scale(away, 1.0f - dist / STEER_SEPARATION_DIST));
+
+						// Touching a unit that already reached the same target, stop here too
+						if((steering->flags & STEER_ACTIVE) && (other->flags & STEER_ARRIVED) &&
+							Vector2Equals(steering->target, other->target)) 
+							arrived[s] = 1;
+					}
+
+					// Keep groups heading to the same point together
+					if((steering->flags & STEER_ACTIVE) && (other->flags & STEER_ACTIVE) &&
+						Vector2Equals(steering->target, other->target)) {
+						center = Vector2Add(center, (Vector2) { px[o], py[o] });
+						grouped++;
+					}
+				}
+			}
+		}
+
+		// Static obstacles, same test against the baked layer
+		StaticLayer *statics = &handler->statics;
+		int16_t sc0, sr0, sc1, sr1;
+
+		if(StaticCellRange(statics, pos, STEER_NEIGHBOUR_RADIUS, &sc0, &sr0, &sc1, &sr1)) {
+			for(int16_t r = sr0; r <= sr1; r++) {
+				uint32_t first = statics->cell_start[sc0 + r * statics->layout.cols];
+				uint32_t last = statics->cell_start[sc1 + 1 + r * statics->layout.cols];
+
+				for(uint32_t k = first; k < last; k++) {
+					Vector2 obstacle = (Vector2) { statics->pos_x[k], statics->pos_y[k] };
+					avoidance = Vector2Add(avoidance, SteerAvoid(pos, vel, obstacle, statics->radius[k]));
+				}
+			}
+		}
+
+		// Seek target, slowing down on arrival
+		Vector2 desired = Vector2Zero();
+
+		if(steering->flags & STEER_ACTIVE) {
+			Vector2 to_target = Vector2Subtract(steering->target, pos);
+			float dist = Vector2Length(to_target);
+
+			if(dist > 0) {
+				float speed = UNIT_SPEED * fminf(1.0f, dist / STEER_SLOW_RADIUS);
+				desired = Vector2Scale(to_target, speed / dist);
+			}
+		}
+
+		desired = Vector2Add(desired, Vector2Scale(separation, UNIT_SPEED * STEER_SEPARATION_WEIGHT));
+		desired = Vector2Add(desired, Vector2Scale(avoidance, UNIT_SPEED * STEER_AVOID_WEIGHT));
+
+		if(grouped) {
+			Vector2 to_center = Vector2Subtract(Vector2Scale(center, 1.0f / grouped), pos);
+			desired = Vector2Add(desired, Vector2Scale(Vector2Normalize(to_center), UNIT_SPEED * STEER_COHESION_WEIGHT));
+		}
+
+		fx[s] = desired.x;
+		fy[s] = desired.y;
+	}
+
+	// Accelerate towards desired velocity, no dependencies between units
+	const float max_dv = STEER_MAX_ACCEL * dt;
+
+	for(INT_N s = 0; s < count; s++) {
+		float ax = fx[s] - vx[s];
+		float ay = fy[s] - vy[s];
+
+		float len_sq = ax * ax + ay * ay;
+		float scale = (len_sq > max_dv * max_dv) ? max_dv / sqrtf(len_sq) : 1.0f;
+
+		vx[s] += ax * scale;
+		vy[s] += ay * scale;
+
+		float speed_sq = vx[s] * vx[s] + vy[s] * vy[s];
+		scale = (speed_sq > UNIT_SPEED * UNIT_SPEED) ? UNIT_SPEED / sqrtf(speed_sq) : 1.0f;
+
+		vx[s] *= scale;
+		vy[s] *= scale;
+	}
+
+	// Write results back
+	for(INT_N s = 0; s < count; s++) {
+		comp_Transform *transform = _pool_transforms_get(handler->entities[ids[s]].comp_map.component_id[comp_index(COMP_TRANSFORM)]);
+		transform->velocity = (Vector2) { vx[s], vy[s] };
+
+		if(arrived[s]) steerings[s]->flags |= STEER_ARRIVED;
+	}
+}
+
+// Distance an entity still has to travel through its queued orders
+static float RemainingPathLength(Handler *handler, INT_N entity_id, Vector2 position) {
+	comp_Orders *orders = HandlerGetComponent(handler, entity_id, COMP_ORDERS);
+	if(!orders || !orders->count) return FLT_MAX;
+
+	INT_N orders_id = handler->entities[entity_id].comp_map.component_id[comp_index(COMP_ORDERS)];
+	Order *ring = &handler->order_queues[orders_id * ORDER_QUEUE_CAP];
+
+	float length = 0;
+	Vector2 from = position;
+
+	for(uint8_t j = 0; j < orders->count; j++) {
+		Order *order = &ring[(orders->head + j) % ORDER_QUEUE_CAP];
+		if(order->type == ORDER_HOLD) break;
+
+		length += Vector2Distance(from, order->target);
+		from = order->target;
+	}
+
+	return length;
+}
+
+// Cached target is still alive, hostile and in range
+static bool TurretTargetValid(Handler *handler, comp_Turret *turret, Vector2 position) {
+	if(turret->target < 0 || turret->target >= handler->entity_count) return false;
+
+	comp_Health *health = HandlerGetComponent(handler, turret->target, COMP_HEALTH);
+	if(!health || health->hp <= 0 || health->team == turret->team) return false;
+
+	comp_Transform *transform = HandlerGetComponent(handler, turret->target, COMP_TRANSFORM);
+	if(!transform) return false;
+
+	// Target slipped into fog
+	if(turret->team == VISION_TEAM && !VisibilityAt(&handler->visibility, transform->position)) return false;
+
+	return Vector2DistanceSqr(position, transform->position) <= turret->range * turret->range;
+}
+
+// Best target in range by turret policy, -1 if there's none
+static INT_N TurretSearch(Handler *handler, comp_Turret *turret, Vector2 position) {
+	Grid *grid = &handler->grid;
+	float range_sq = turret->range * turret->range;
+
+	// Cells overlapping range
+	Rectangle reach = (Rectangle) { position.x - turret->range, position.y - turret->range, turret->range * 2, turret->range * 2 };
+
+	int32_t col_start, row_start, col_end, row_end;
+	GridQueryRange(grid, reach, &col_start, &row_start, &col_end, &row_end);
+
+	INT_N best = -1;
+	float best_score = FLT_MAX;
+
+	// While dense grid and visibility cells match fogged cells are skipped whole,
+	// after the grid is retuned or on sparse grids each target is checked on its own
+	bool fogged = (turret->team == VISION_TEAM);
+	bool aligned = (grid->type == GRID_DENSE) && CellLayoutEqual(&grid->layout, &handler->visibility.layout);
+
+	for(int32_t r = row_start; r <= row_end; r++) {
+		for(int32_t c = col_start; c <= col_end; c++) {
+			if(fogged && aligned && !VisibilityCellVisible(&handler->visibility, GridCoordsToId(c, r, grid))) continue;
+
+			GridCell *cell = GridCellAt(grid, c, r);
+			if(!cell) continue;
+
+			grid->stats.entries += cell->entity_count;
+
+			for(INT_N j = 0; j < cell->entity_count; j++) {
+				INT_N id = cell->entities[j];
+
+				comp_Health *health = HandlerGetComponent(handler, id, COMP_HEALTH);
+				if(!health || health->hp <= 0 || health->team == turret->team) continue;
+
+				comp_Transform *transform = HandlerGetComponent(handler, id, COMP_TRANSFORM);
+				float dist_sq = Vector2DistanceSqr(position, transform->position);
+				if(dist_sq > range_sq) continue;
+
+				if(fogged && !aligned && !VisibilityAt(&handler->visibility, transform->position)) continue;
+
+				// Lower is better
+				float score;
+				switch(turret->policy) {
+					case TARGET_FIRST:		score = RemainingPathLength(handler, id, transform->position);	break;
+					case TARGET_STRONGEST:	score = -health->hp;											break;
+					default:				score = dist_sq;												break;
+				}
+
+				if(best < 0 || score < best_score) {
+					best = id;
+					best_score = score;
+				}
+			}
+		}
+	}
+
+	return best;
+}
+
+void VisionUpdate(Handler *handler) {
+	Visibility *vis = &handler->visibility;
+
+	// Sources that didn't move can't have changed cell
+	for(INT_N t = SlotsNext(_pool_transforms.dirty, SLOT_WORDS(_pool_transforms.count), 0); t >= 0; 
+		t = SlotsNext(_pool_transforms.dirty, SLOT_WORDS(_pool_transforms.count), t + 1)) {
+
+		// Released slots are marked too when everything is marked changed
+		INT_N entity_id = _pool_transforms.owners[t];
+		if(entity_id < 0 || !(handler->entities[entity_id].components & COMP_VISION)) continue;
+
+		INT_N vision_id = handler->entities[entity_id].comp_map.component_id[comp_index(COMP_VISION)];
+		comp_Vision *vision = _pool_visions_get(vision_id);
+
+		int32_t cell = VisibilityCell(vis, _pool_transforms.data[t].position);
+		uint8_t cells = VisibilityRadiusCells(vis, vision->radius);
+
+		if(cell == vision->cell && cells == vision->cells) continue;
+
+		// Leaving only decrements, entering only increments
+		VisibilityStamp(vis, vision->cell, vision->cells, -1);
+		VisibilityStamp(vis, cell, cells, 1);
+
+		vision->cell = cell;
+		vision->cells = cells;
+		_pool_visions_mark_dirty(vision_id);
+	}
+}
+
+void TurretsUpdate(Handler *handler, float dt) {
+	// Set component mask
+	uint32_t mask = (COMP_TRANSFORM | COMP_TURRET);
+
+	for(INT_N i = 0; i < handler->entity_count; i++) {
+		Entity *entity = &handler->entities[i];
+
+		// Skip entities that don't have required components
+		if((entity->components & mask) != mask) continue;
+
+		comp_Transform *transform = _pool_transforms_get(entity->comp_map.component_id[comp_index(COMP_TRANSFORM)]);
+		comp_Turret *turret = _pool_turrets_get(entity->comp_map.component_id[comp_index(COMP_TURRET)]);
+
+		if(turret->timer > 0) turret->timer -= dt;
+
+		// Keep cached target while it's valid, otherwise search on this turret's tick
+		if(!TurretTargetValid(handler, turret, transform->position)) {
+			turret->target = -1;
+
+			if((handler->tick + i) % TURRET_SEARCH_INTERVAL) continue;
+
+			turret->target = TurretSearch(handler, turret, transform->position);
+			if(turret->target < 0) continue;
+		}
+
+		if(turret->timer > 0) continue;
+
+		// Fire at target's current position
+		comp_Transform *target_transform = HandlerGetComponent(handler, turret->target, COMP_TRANSFORM);
+		Vector2 direction = Vector2Normalize(Vector2Subtract(target_transform->position, transform->position));
+
+		// Lives long enough to cross the whole range
+		float lifetime = (turret->range / TURRET_PROJECTILE_SPEED) * 1.5f;
+
+		ProjectileSpawn(&handler->projectiles, transform->position, Vector2Scale(direction, TURRET_PROJECTILE_SPEED), 
+			lifetime, turret->damage, i, turret->team);
+
+		turret->timer = turret->cooldown;
 	}
 }
 
+void ProjectilesUpdate(Handler *handler, float dt) {
+	Projectiles *p = &handler->projectiles;
+	Grid *grid = &handler->grid;
+
+	ProjectilesIntegrate(p, dt);
+
+	const float hit_radius = PROJECTILE_RADIUS + STEER_UNIT_RADIUS;
+
+	// Back to front, despawning moves an already checked projectile into the current slot
+	for(uint32_t i = p->count; i-- > 0;) {
+		if(p->lifetime[i] <= 0) {
+			ProjectileDespawn(p, i);
+			continue;
+		}
+
+		// Path covered this tick, tested as a whole so fast projectiles can't skip over targets
+		Vector2 to = (Vector2) { p->pos_x[i], p->pos_y[i] };
+		Vector2 from = (Vector2) { to.x - p->vel_x[i] * dt, to.y - p->vel_y[i] * dt };
+		Vector2 path = Vector2Subtract(to, from);
+		float path_sq = Vector2LengthSqr(path);
+
+		// Cells overlapping path bounds
+		Rectangle bounds = (Rectangle) {
+			.x = fminf(from.x, to.x) - hit_radius,
+			.y = fminf(from.y, to.y) - hit_radius,
+			.width = fabsf(path.x) + hit_radius * 2,
+			.height = fabsf(path.y) + hit_radius * 2
+		};
+
+		int32_t col_start, row_start, col_end, row_end;
+		GridQueryRange(grid, bounds, &col_start, &row_start, &col_end, &row_end);
+
+		// Earliest hit along path
+		INT_N hit = -1;
+		float hit_t = FLT_MAX;
+
+		for(int32_t r = row_start; r <= row_end; r++) {
+			for(int32_t c = col_start; c <= col_end; c++) {
+				GridCell *cell = GridCellAt(grid, c, r);
+				if(!cell) continue;
+
+				grid->stats.entries += cell->entity_count;
+
+				for(INT_N j = 0; j < cell->entity_count; j++) {
+					INT_N id = cell->entities[j];
+
+					comp_Health *health = HandlerGetComponent(handler, id, COMP_HEALTH);
+					if(!health || health->hp <= 0 || health->team == p->team[i]) continue;
+
+					comp_Transform *transform = HandlerGetComponent(handler, id, COMP_TRANSFORM);
+
+					// Closest point on path to target
+					float t = (path_sq > 0) ? Clamp(Vector2DotProduct(Vector2Subtract(transform->position, from), path) / path_sq, 0, 1) : 0;
+					Vector2 closest = Vector2Add(from, Vector2Scale(path, t));
+
+					if(Vector2DistanceSqr(closest, transform->position) > hit_radius * hit_radius) continue;
+
+					if(t < hit_t) {
+						hit = id;
+						hit_t = t;
+					}
+				}
+			}
+		}
+
+		if(hit < 0) continue;
+
+		comp_Health *health = HandlerGetComponentMut(handler, hit, COMP_HEALTH);
+		health->hp -= p->damage[i];
+
+		if(health->hp <= 0) KillEntity(handler, hit);
+		else HandlerPushEffect(handler, EFFECT_SPARK, Vector2Add(from, Vector2Scale(path, hit_t)));
+
+		ProjectileDespawn(p, i);
+	}
+}
+
+Order *OrdersFront(Handler *handler, INT_N orders_id) {
+	comp_Orders *orders = _pool_orders_get(orders_id);
+	if(!orders->count) return NULL;
+
+	return &handler->order_queues[orders_id * ORDER_QUEUE_CAP + orders->head];
+}
+
+Order *OrdersBack(Handler *handler, INT_N orders_id) {
+	comp_Orders *orders = _pool_orders_get(orders_id);
+	if(!orders->count) return NULL;
+
+	uint8_t back = (orders->head + orders->count - 1) % ORDER_QUEUE_CAP;
+	return &handler->order_queues[orders_id * ORDER_QUEUE_CAP + back];
+}
+
+bool OrdersPush(Handler *handler, INT_N orders_id, Order order) {
+	comp_Orders *orders = _pool_orders_get(orders_id);
+	if(orders->count >= ORDER_QUEUE_CAP) return false;
+
+	uint8_t slot = (orders->head + orders->count) % ORDER_QUEUE_CAP;
+	handler->order_queues[orders_id * ORDER_QUEUE_CAP + slot] = order;
+	orders->count++;
+
+	return true;
+}
+
+void OrdersPop(Handler *handler, INT_N orders_id) {
+	comp_Orders *orders = _pool_orders_get(orders_id);
+	if(!orders->count) return;
+
+	orders->head = (orders->head + 1) % ORDER_QUEUE_CAP;
+	orders->count--;
+}
+
+void OrdersClear(Handler *handler, INT_N orders_id) {
+	comp_Orders *orders = _pool_orders_get(orders_id);
+	orders->head = 0;
+	orders->count = 0;
+}
+
+void *HandlerGetComponent(Handler *handler, INT_N entity_id, uint32_t component) {
+	Entity *entity = &handler->entities[entity_id];
+	if(!(entity->components & component)) return NULL;
+
+	INT_N comp_id = entity->comp_map.component_id[comp_index(component)];
+
+	return component_types[comp_index(component)].ref(comp_id);
+}
+
+void *HandlerGetComponentMut(Handler *handler, INT_N entity_id, uint32_t component) {
+	Entity *entity = &handler->entities[entity_id];
+	if(!(entity->components & component)) return NULL;
+
+	uint32_t i = comp_index(component);
+	INT_N comp_id = entity->comp_map.component_id[i];
+
+	slot_set(*component_types[i].dirty, comp_id);
+	return component_types[i].ref(comp_id);
+}
+
+bool HandlerChanged(Handler *handler, INT_N entity_id, uint32_t component) {
+	Entity *entity = &handler->entities[entity_id];
+	if(!(entity->components & component)) return false;
+
+	uint32_t i = comp_index(component);
+	return slot_test(*component_types[i].dirty, entity->comp_map.component_id[i]);
+}
+
 void PrintComponentMappings(Handler *handler, INT_N entity_id) {
 	printf("____________________________________________________\n");
 	printf("______ component mappings for entity [%04d] ________\n", entity_id);
 	printf("____________________________________________________\n");
 
 	Entity *entity = &handler->entities[entity_id];
-	for(short i = 0; i < COMP_TYPE_COUNT; i++) {
+	for(short i = 0; i < COMP_REGISTERED_COUNT; i++) {
 		char id_str[32];
 
 		if(entity->comp_map.component_id[i] > COMP_NULL)
@@ -179,173 +1333,210 @@ void PrintComponentMappings(Handler *handler, INT_N entity_id) {
 		else 
 			snprintf(id_str, sizeof(id_str), "%s", COMP_NULL_ALIAS);
 
-		printf("| mapping: %s = %s\n", comp_names[i], id_str);	
+		printf("| mapping: %-12s = %s\n", component_types[i].name, id_str);	
 	}
 
 	printf("____________________________________________________\n");
 }
 
-void CheckSelectedUnits(Handler *handler, Rectangle rec) {
-	// Convert window space rectangle to game space
-	rec = ScaledRecWithCamera(rec, handler->camera);
-		
-	// Set bit mask to components required for selection
-	uint32_t mask = (COMP_TRANSFORM | COMP_SELECTABLE);
+void GridInit(Grid *grid, uint8_t type, CellLayout layout, uint8_t cell_cap) {
+	// Sparse grid starts with an empty table, cells are pooled as they fill
+	if(type == GRID_SPARSE) {
+		*grid = (Grid) {
+			.layout = layout,
+			.cell_cap = cell_cap,
+			.type = GRID_SPARSE,
+			.slots = TrackedMalloc(GRID_SPARSE_MIN_SLOTS * sizeof(GridSlot)),
+			.slot_mask = GRID_SPARSE_MIN_SLOTS - 1
+		};
+
+		for(uint32_t i = 0; i < GRID_SPARSE_MIN_SLOTS; i++) 
+			grid->slots[i].cell = -1;
+
+		return;
+	}
 
-	// Iterate entities
-	for(INT_N i = 0; i < handler->entity_count; i++) {
-		Entity *entity = &handler->entities[i];
+	uint16_t cell_count = layout.cols * layout.rows;
 
-		// Skip selecting entities that don't have required components
-		if(!(entity->components & mask)) continue;
+	Grid new_grid = (Grid) {
+		.layout = layout,
+		.cell_count = cell_count,
+		.cell_cap = cell_cap,
+		.type = GRID_DENSE,
+		.cells = TrackedCalloc(cell_count, sizeof(GridCell)),
+		.entries = TrackedCalloc(cell_count * cell_cap, sizeof(INT_N))
+	};
 
-		// Get components
-		comp_Transform *transform = _pool_transforms_get(entity->comp_map.component_id[1 >> COMP_TRANSFORM]);
-		comp_Selectable *selectable = _pool_selectables_get(entity->comp_map.component_id[1 >> COMP_SELECTABLE]);
+	for(uint16_t i = 0; i < cell_count; i++) 
+		new_grid.cells[i].entities = &new_grid.entries[i * cell_cap];
 
-		// Clear selected flag
-		selectable->flags &= ~SELECTED;
+	*grid = new_grid;
+}
 
-		// Set selected flag on if in box
-		if(CheckCollisionCircleRec(transform->position, 10, rec)) {
-			selectable->flags |= SELECTED;
-		}
-	}
+void GridClose(Grid *grid) {
+	TrackedFree(grid->cells);
+	TrackedFree(grid->entries);
+	TrackedFree(grid->slots);
+	TrackedFree(grid->free_cells);
 }
 
-void GridInit(Grid *grid, Vector2 cell_size, uint16_t cols, uint16_t rows) {
-	Grid new_grid = (Grid) {
-		.cell_size = cell_size,
-		.cols = cols,
-		.rows = rows,
-		.cell_count = (cols * rows),
-		.cells = calloc((cols * rows), sizeof(GridCell))
-	};
+// Add to cell at coordinates from 'GridCellCoords()', dropped if cell is full
+static void GridAddAt(Grid *grid, int32_t c, int32_t r, INT_N entity_id) {
+	GridCell *cell = (grid->type == GRID_DENSE) ? GridCellAt(grid, c, r) : GridSparseAcquire(grid, c, r);
 
-	*grid = new_grid;
+	// Don't add if cell is full 
+	if(!cell || cell->entity_count >= grid->cell_cap) 
+		return;
+
+	cell->entities[cell->entity_count++] = entity_id;
 }
 
-void GridClose(Grid *grid) {
-	free(grid->cells);
+static void GridRemoveAt(Grid *grid, int32_t c, int32_t r, INT_N entity_id) {
+	GridCell *cell = GridCellAt(grid, c, r);
+	if(!cell || !GridCellRemove(cell, entity_id)) return;
+
+	if(grid->type == GRID_SPARSE && cell->entity_count == 0) 
+		GridSparseRelease(grid, cell);
 }
 
 void GridUpdate(Grid *grid, Handler *handler) {
-	// Set component mask
-	uint32_t mask = (COMP_TRANSFORM);
+	// Only transforms that moved this tick
+	for(INT_N t = SlotsNext(_pool_transforms.dirty, SLOT_WORDS(_pool_transforms.count), 0); t >= 0; 
+		t = SlotsNext(_pool_transforms.dirty, SLOT_WORDS(_pool_transforms.count), t + 1)) {
 
-	// Iterate entities
-	for(INT_N i = 0; i < handler->entity_count; i++) {
-		// Get pointer to entity
-		Entity *entity = &handler->entities[i];
+		INT_N entity_id = _pool_transforms.owners[t];
+		comp_Transform *transform = &_pool_transforms.data[t];
 
-		// Skip iterating entities that don't have required components 
-		if(!(entity->components & mask)) continue;
+		// Skip update if entity hasn't moved, exactly: 'Vector2Equals()' tolerance can hide a cell change
+		if(transform->position.x == transform->prev_position.x && transform->position.y == transform->prev_position.y) continue;
 
-		// Get transform component
-		comp_Transform *transform = _pool_transforms_get(entity->comp_map.component_id[1 >> COMP_TRANSFORM]);
+		// Cells of current and previous position, either may be outside a dense grid
+		int32_t c_curr = 0, r_curr = 0, c_prev = 0, r_prev = 0;
+		bool in_curr = GridCellCoords(grid, transform->position, &c_curr, &r_curr);
+		bool in_prev = GridCellCoords(grid, transform->prev_position, &c_prev, &r_prev);
 
-		// Skip update if entity hasn't moved	
-		if(Vector2Equals(transform->position, transform->prev_position)) continue;
+		// Skip update if entity hasn't changed cells
+		if(in_curr == in_prev && c_curr == c_prev && r_curr == r_prev) continue;
 
-		// Get transform's current position in grid 
-		int16_t cell_col_curr =(transform->position.x / grid->cell_size.x);
-		int16_t cell_row_curr =(transform->position.y / grid->cell_size.y);
-		
-		// Get transform's previous position in grid 
-		int16_t cell_col_prev = (transform->prev_position.x / grid->cell_size.x);
-		int16_t cell_row_prev = (transform->prev_position.y / grid->cell_size.y);
+		// Leaving grid only removes, entering only adds
+		if(in_prev) GridRemoveAt(grid, c_prev, r_prev, entity_id);
+		if(in_curr) GridAddAt(grid, c_curr, r_curr, entity_id);
+	}
+}
 
-		// Skip update if entity hasn't changed cells
-		if(cell_col_curr == cell_col_prev && cell_row_curr == cell_row_prev) continue;
-
-		// Skip updates on out of bounds cells
-		if(!(IsCellInBounds(cell_col_curr, cell_row_curr, grid))) continue;
-		if(!(IsCellInBounds(cell_col_prev, cell_row_prev, grid))) continue;
-
-		GridCell *cell_curr = &grid->cells[GridCoordsToId(cell_col_curr, cell_row_curr, grid)];
-		GridCell *cell_prev = &grid->cells[GridCoordsToId(cell_col_prev, cell_row_prev, grid)];
-
-		// Remove entity from previous cell
-		// 1. Search for entity
-		for(INT_N j = cell_prev->entity_count; j >= 0; j--) {
-			INT_N to_remove = cell_prev->entities[j];
-			
-			if(to_remove == entity->id) {
-				// 2. Compact array
-				for(uint16_t k = j; k < cell_prev->entity_count - 1; k++) {
-					cell_prev->entities[k] = cell_prev->entities[k + 1];
-				}
+void GridInsert(Grid *grid, INT_N entity_id, Vector2 position) {
+	int32_t c, r;
+	if(GridCellCoords(grid, position, &c, &r)) GridAddAt(grid, c, r, entity_id);
+}
 
-				// 3. Decrement count
-				cell_prev->entity_count--;
+void GridRemove(Grid *grid, INT_N entity_id, Vector2 position) {
+	int32_t c, r;
+	if(GridCellCoords(grid, position, &c, &r)) GridRemoveAt(grid, c, r, entity_id);
+}
 
-				break;
-			}
+bool GridCellRemove(GridCell *cell, INT_N entity_id) {
+	// 1. Search for entity
+	for(INT_N j = cell->entity_count - 1; j >= 0; j--) {
+		if(cell->entities[j] != entity_id) continue;
+
+		// 2. Compact array
+		for(INT_N k = j; k < cell->entity_count - 1; k++) {
+			cell->entities[k] = cell->entities[k + 1];
 		}
 
-		// Don't add if cell is full 
-		if(cell_curr->entity_count - 1 >= MAX_ENTITIES_PER_CELL) 
-			continue;	
+		// 3. Decrement count
+		cell->entity_count--;
 
-		// Add entity to current cell
-		cell_curr->entities[cell_curr->entity_count++] = entity->id;
+		return true;
 	}
+
+	return false;
 }
 
 int16_t GridCoordsToId(int16_t c, int16_t r, Grid *grid) {
-	return (int16_t)(c + r * grid->cols);
+	return (int16_t)(c + r * grid->layout.cols);
 }
 
 bool IsCellInBounds(int16_t c, int16_t r, Grid *grid) {
-	if(c < 0 || r < 0) 
-		return false;	
+	return CellInLayout(&grid->layout, c, r);
+}
 
-	if(c >= grid->cols - 1 || r >= grid->rows - 1)
+// Sparse column or row, clamped so it fits 'int32_t'
+static float GridSparseCoord(float v) {
+	return fminf(fmaxf(v, -GRID_SPARSE_COORD_MAX), GRID_SPARSE_COORD_MAX);
+}
+
+bool GridCellCoords(Grid *grid, Vector2 position, int32_t *c, int32_t *r) {
+	float col = CellCol(&grid->layout, position.x);
+	float row = CellRow(&grid->layout, position.y);
+
+	if(grid->type == GRID_SPARSE) {
+		col = GridSparseCoord(col);
+		row = GridSparseCoord(row);
+
+	} else if(col < 0 || row < 0 || col >= grid->layout.cols || row >= grid->layout.rows) {
 		return false;
+	}
+
+	*c = col;
+	*r = row;
 
 	return true;
 }
 
-void GridRenderDebugView(Grid *grid, Handler *handler) {
-	float z = handler->camera->zoom;
-
-	int16_t frame_w = ((VIRTUAL_WIDTH) / (grid->cell_size.x)) / z;
-	int16_t frame_h = ((VIRTUAL_HEIGHT) / (grid->cell_size.y) / z);
-	
-	Vector2 cam_pos = GetScreenToWorld2D(Vector2Zero(), *handler->camera);
-	Vector2 cam_end = GetScreenToWorld2D((Vector2){GetScreenWidth(), GetScreenHeight()}, *handler->camera);
+void GridQueryRange(Grid *grid, Rectangle rec, int32_t *col_start, int32_t *row_start, int32_t *col_end, int32_t *row_end) {
+	if(grid->type == GRID_SPARSE) {
+		*col_start = GridSparseCoord(CellCol(&grid->layout, rec.x));
+		*row_start = GridSparseCoord(CellRow(&grid->layout, rec.y));
+		*col_end = GridSparseCoord(CellCol(&grid->layout, rec.x + rec.width));
+		*row_end = GridSparseCoord(CellRow(&grid->layout, rec.y + rec.height));
+
+	} else {
+		int16_t cs, rs, ce, re;
+		CellRange(&grid->layout, rec, &cs, &rs, &ce, &re);
+
+		*col_start = cs;
+		*row_start = rs;
+		*col_end = ce;
+		*row_end = re;
+	}
 
-	int16_t camera_col = cam_pos.x / grid->cell_size.x;
-	int16_t camera_row = cam_pos.y / grid->cell_size.y;
+	GridStats *stats = &grid->stats;
+	stats->queries++;
+	stats->cells += (uint64_t)(*col_end - *col_start + 1) * (*row_end - *row_start + 1);
+	stats->extent += (rec.width + rec.height) * 0.5;
+}
 
-	int16_t camera_col_end = cam_end.x / grid->cell_size.x;
-	int16_t camera_row_end = cam_end.y / grid->cell_size.y;
+void GridQueryRec(Grid *grid, Rectangle rec, vec_ent *out) {
+	// Get cell range covered by rectangle
+	int32_t col_start, row_start, col_end, row_end;
+	GridQueryRange(grid, rec, &col_start, &row_start, &col_end, &row_end);
 
-	camera_col_end = Clamp(camera_col_end, frame_w, grid->cols);
-	camera_row_end = Clamp(camera_row_end, frame_h, grid->rows);
+	// Range larger than the sparse pool, test occupied cells instead of looking up each one
+	uint64_t span = (uint64_t)(col_end - col_start + 1) * (row_end - row_start + 1);
 
-	camera_col = Clamp(camera_col, 0, grid->cols - frame_w);
-	camera_row = Clamp(camera_row, 0, grid->rows - frame_h);
+	if(grid->type == GRID_SPARSE && span > grid->cell_count) {
+		for(uint16_t i = 0; i < grid->cell_count; i++) {
+			GridCell *cell = &grid->cells[i];
 
-	for(int16_t r = camera_row; r < camera_row_end; r++) {
-		for(int16_t c = camera_col; c < camera_col_end; c++) {
-			Vector2 pos = (Vector2) { .x = c * grid->cell_size.x, .y = r * grid->cell_size.y };
+			if(!cell->entity_count || cell->col < col_start || cell->col > col_end || cell->row < row_start || cell->row > row_end) 
+				continue;
 
-			Color color = DARKGRAY;
+			vec_ent_append(out, cell->entities, cell->entity_count);
+			grid->stats.entries += cell->entity_count;
+		}
 
-			GridCell *cell = &grid->cells[GridCoordsToId(c, r, grid)];
-			if(cell->entity_count > 0) color = RAYWHITE;
+		return;
+	}
 
-			Rectangle rec = (Rectangle) {
-				.x = pos.x,
-				.y = pos.y,
-				.width = grid->cell_size.x,
-				.height = grid->cell_size.y
-			};
+	// Copy each cell's entity list in bulk
+	for(int32_t r = row_start; r <= row_end; r++) {
+		for(int32_t c = col_start; c <= col_end; c++) {
+			GridCell *cell = GridCellAt(grid, c, r);
+			if(!cell) continue;
 
-			DrawRectangleLinesEx(rec, 1.5f, color);
-			DrawText(TextFormat("Count: %d", cell->entity_count), pos.x + 4, pos.y + 4, 10, color);
+			vec_ent_append(out, cell->entities, cell->entity_count);
+			grid->stats.entries += cell->entity_count;
 		}
 	}
 }
-
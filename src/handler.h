@@ -1,6 +1,15 @@
 #include <stddef.h>
 #include <stdint.h>
 #include "raylib.h"
+#include "memory.h"
+#include "vec.h"
+#include "kmath.h"
+#include "render.h"
+#include "cells.h"
+#include "projectiles.h"
+#include "waves.h"
+#include "statics.h"
+#include "visibility.h"
 
 #ifndef HANDLER_H_
 #define HANDLER_H_
@@ -8,12 +17,16 @@
 // Type used for indexing/count of entities and components, easy to change if needed
 #define INT_N int16_t
 
-#define ENTITY_CAP 1024
-#define COMP_CAP	512
+#define ENTITY_CAP 8192
+#define COMP_CAP	8192
 
-// How many component types there are
+// Most component types, size of mapping arrays
 #define COMP_TYPE_COUNT 	32
 
+// Limits checked at compile time for every registered component
+#define COMP_MAX_SIZE		64
+#define COMP_MAX_ALIGN		8
+
 // No component
 #define COMP_NULL			-1
 #define COMP_NULL_ALIAS		"comp_null"
@@ -21,41 +34,44 @@
 // Maximum log message size
 #define MESSAGE_CAP			1024
 
+// List of entity ids, used for query results and other transient id buffers
+vec_declare(vec_ent, INT_N)
+
+// *
+// Component registry, one line per component type
+// X(ID, field, pool, type)
+//
+// Generates bits ('B_COMP_ID'), indices ('CI_ID'), pools ('_pool_pool') and the 'component_types' table
+// Bit order, and snapshot layout, follow list order: append new components at the end
+// *
+#define COMPONENT_LIST(X)												\
+	X(TRANSFORM,	transform,	transforms,		comp_Transform)		\
+	X(SPRITE,		sprite,		sprites,		comp_Sprite)		\
+	X(SELECTABLE,	selectable,	selectables,	comp_Selectable)	\
+	X(ORDERS,		orders,		orders,			comp_Orders)		\
+	X(STEERING,		steering,	steerings,		comp_Steering)		\
+	X(OBSTACLE,		obstacle,	obstacles,		comp_Obstacle)		\
+	X(HEALTH,		health,		healths,		comp_Health)		\
+	X(TURRET,		turret,		turrets,		comp_Turret)		\
+	X(EMITTER,		emitter,	emitters,		comp_Emitter)		\
+	X(VISION,		vision,		visions,		comp_Vision)
+
+#define comp_enum_index(_id, _field, _pool, _type) CI_##_id,
+#define comp_enum_bit(_id, _field, _pool, _type) B_COMP_##_id = (1u << CI_##_id),
+
+enum COMP_INDICES {
+	COMPONENT_LIST(comp_enum_index)
+	COMP_REGISTERED_COUNT
+};
+
 enum COMP_BITS {
-		B_COMP_TRANSFORM		= 0x00000001,
-		B_COMP_SPRITE			= 0x00000002,
-		B_COMP_SELECTABLE		= 0x00000004,
-		B_empty2			 	= 0x00000008,
-		B_empty4			 	= 0x00000010,
-		B_empty5			 	= 0x00000020,
-		B_empty6			 	= 0x00000040,
-		B_empty7			 	= 0x00000080,
-		B_empty8			 	= 0x00000100,
-		B_empty9			 	= 0x00000200,
-		B_empty10			 	= 0x00000400,
-		B_empty11			 	= 0x00000800,
-		B_empty12 				= 0x00001000,
-		B_empty13 				= 0x00002000,
-		B_empty14 				= 0x00004000,
-		B_empty15 				= 0x00008000,
-		B_empty16 				= 0x00010000,
-		B_empty17 				= 0x00020000,
-		B_empty18 				= 0x00040000,
-		B_empty19 				= 0x00080000,
-		B_empty20 				= 0x00100000,
-		B_empty21 				= 0x00200000,
-		B_empty22 				= 0x00400000,
-		B_empty23 				= 0x00800000,
-		B_empty24 				= 0x01000000,
-		B_empty25 				= 0x02000000,
-		B_empty26 				= 0x04000000,
-		B_empty27 				= 0x08000000,
-		B_empty28 				= 0x10000000,
-		B_empty29 				= 0x20000000,
-		B_empty30 				= 0x40000000,
-		B_empty31 				= 0x80000000
+	COMPONENT_LIST(comp_enum_bit)
 };
 
+// Index of a component type in mapping arrays
+// eg. comp_index(COMP_SPRITE) = 1
+#define comp_index(_bit) (__builtin_ctz(_bit))
+
 
 // Component mapping struct
 // Has array containining indices of components. 
@@ -119,28 +135,378 @@ typedef struct {
 	uint8_t flags;
 
 } comp_Selectable;
+
+// Orders component
+// Queue of orders a unit follows, order data is kept in the handler's shared ring pool:
+// ring for component index i starts at 'order_queues[i * ORDER_QUEUE_CAP]'
+#define COMP_ORDERS B_COMP_ORDERS
+#define ORDER_QUEUE_CAP		8
+
+// Unit movement speed (pixels per second) when following orders
+#define UNIT_SPEED			180.0f
+
+enum ORDER_TYPES {
+	ORDER_NONE,
+	ORDER_MOVE,
+	ORDER_ATTACK_MOVE,
+	ORDER_HOLD,
+	ORDER_PATROL
+};
+
+typedef struct {
+	Vector2 target;
+	Vector2 origin;		// Patrol return point
+
+	uint8_t type;
+
+} Order;
+
+typedef struct {
+	uint8_t head;
+	uint8_t count;
+
+} comp_Orders;
+
+// Steering component
+// Units with steering get their velocity from 'SteeringUpdate()',
+// orders only set where to go
+#define COMP_STEERING B_COMP_STEERING
+#define STEER_ACTIVE			0x01	// Moving towards 'target'
+#define STEER_ARRIVED			0x02	// Reached 'target' (or touched a unit that did)
+
+#define STEER_UNIT_RADIUS		10.0f
+#define STEER_SEPARATION_DIST	(STEER_UNIT_RADIUS * 2.5f)
+#define STEER_NEIGHBOUR_RADIUS	48.0f
+#define STEER_MAX_NEIGHBOURS	16
+
+// Distance at which units start slowing down, and count as arrived
+#define STEER_SLOW_RADIUS		48.0f
+#define STEER_ARRIVE_DIST		8.0f
+
+// Pixels per second squared
+#define STEER_MAX_ACCEL			1200.0f
+
+// Seconds of movement checked ahead for obstacles
+#define STEER_LOOKAHEAD			0.25f
+
+// Force weights, relative to 'UNIT_SPEED'
+#define STEER_SEPARATION_WEIGHT	1.5f
+#define STEER_COHESION_WEIGHT	0.2f
+#define STEER_AVOID_WEIGHT		2.0f
+
+typedef struct {
+	Vector2 target;
+
+	uint8_t flags;
+
+} comp_Steering;
+
+// Obstacle component
+// Units with steering move around entities with this component
+#define COMP_OBSTACLE B_COMP_OBSTACLE
+typedef struct {
+	float radius;
+
+} comp_Obstacle;
+
+// Health component
+// Entities with health and a different team are valid turret targets
+#define COMP_HEALTH B_COMP_HEALTH
+typedef struct {
+	float hp;
+	float max_hp;
+
+	uint8_t team;
+
+} comp_Health;
+
+// Turret component
+#define COMP_TURRET B_COMP_TURRET
+
+// Turrets without a target search for one every N ticks,
+// spread over ticks by entity id so they never all search at once
+#define TURRET_SEARCH_INTERVAL	4
+
+// Pixels per second
+#define TURRET_PROJECTILE_SPEED	600.0f
+
+enum TARGET_POLICIES {
+	TARGET_NEAREST,		// Closest to turret
+	TARGET_FIRST,		// Least distance left along its queued orders
+	TARGET_STRONGEST	// Most hp
+};
+
+typedef struct {
+	float range;
+	float damage;
+	float cooldown;		// Seconds between shots
+	float timer;		// Seconds until next shot
+
+	// Cached target entity id, -1 if none
+	INT_N target;
+
+	uint8_t policy;
+	uint8_t team;
+
+} comp_Turret;
+
+// Emitter component
+// Continuous particle effect, eg. thrusters, only drawn while entity is moving
+#define COMP_EMITTER B_COMP_EMITTER
+typedef struct {
+	float rate;			// Particles per second
+	uint8_t type;		// 'EFFECT_TYPES'
+
+} comp_Emitter;
+
+// Vision component
+// Reveals cells around the entity for the fog of war, see 'Visibility'
+#define COMP_VISION B_COMP_VISION
+typedef struct {
+	float radius;
+
+	// Cell and radius in cells currently stamped, cell is -1 until first stamped
+	int16_t cell;
+	uint8_t cells;
+
+} comp_Vision;
 // ----------------------------------------
 
 // ----------------------------------------
 // 			Spatial Partitioning 
 // ----------------------------------------
-#define MAX_ENTITIES_PER_CELL 128
+// Entries per cell when not set by config, later entries are dropped
+#define GRID_DEFAULT_CELL_CAP	128
+
+// Cell size when not set by config
+#define GRID_DEFAULT_CELL_SIZE	96
+
+// Area covered when no level is loaded
+#define GRID_DEFAULT_COLS		128
+#define GRID_DEFAULT_ROWS		128
+
+// World space kept around level content, units spread out past spawn and target points
+#define GRID_LEVEL_MARGIN		1024
+
+// Auto-tune: ticks between decisions, query work is summed over this many
+#define GRID_TUNE_INTERVAL		300
+
+// Fewer queries than this in an interval tell too little to retune on
+#define GRID_TUNE_MIN_QUERIES	256
+
+// Relative cost of visiting a cell and of testing one of its entries
+#define GRID_TUNE_CELL_COST		1.0f
+#define GRID_TUNE_ENTRY_COST	2.0f
+
+// Cell sizes tried, each a fourth of an octave larger than the last
+#define GRID_TUNE_MIN_SIZE		32
+#define GRID_TUNE_MAX_SIZE		1024
+#define GRID_TUNE_STEP			1.1892f
+
+// Retune only if predicted cost per query drops below this fraction of current
+#define GRID_TUNE_GAIN			0.8f
+
+// Fullest cell, scaled to the new cell area, must stay under this fraction of capacity
+#define GRID_TUNE_FILL			0.5f
+
+// Grid storage, chosen per level
+enum GRID_TYPES {
+	GRID_DENSE,		// Array of cells over fitted bounds, positions outside aren't partitioned
+	GRID_SPARSE		// Hash table of occupied cells, unbounded, memory follows occupied cells
+};
+
+// Sparse grid: initial table slots and pooled cells, both double when full
+#define GRID_SPARSE_MIN_SLOTS	64
+#define GRID_SPARSE_MIN_CELLS	32
+
+// Sparse cell coordinates are clamped to this, positions further out share edge cells
+#define GRID_SPARSE_COORD_MAX	(1 << 30)
 
 typedef struct {
-	INT_N entities[MAX_ENTITIES_PER_CELL];
+	INT_N *entities;	// 'cell_cap' slots
 	INT_N entity_count;
+
+	// Sparse only, cell coordinates
+	int32_t col;
+	int32_t row;
 } GridCell;
 
+// Sparse table slot, 'cell' indexes the pool, -1 if slot is empty
+typedef struct {
+	int32_t col;
+	int32_t row;
+	INT_N cell;
+} GridSlot;
+
+// Work done by grid queries since last reset, cell size is tuned against it
+typedef struct {
+	uint32_t queries;
+	uint64_t cells;		// Cells visited
+	uint64_t entries;	// Entries tested
+	double extent;		// Query rectangle sides, width and height averaged
+
+} GridStats;
+
+// *
+// Uniform grid of entity ids
+//
+// Dense grids allocate every cell of 'layout'. Sparse grids only use the layout's origin and
+// cell size: occupied cells come from a pool ('cells', 'cell_count' long) and are found through
+// an open addressing table keyed by cell coordinates. A cell goes back to the pool when its
+// last entity leaves, so memory follows the most cells occupied at once, not the area covered.
+// *
 typedef struct {
 	GridCell *cells;
 
-	Vector2 cell_size;
+	// Entries of all cells, 'cell_cap' per cell
+	INT_N *entries;
+
+	CellLayout layout;
 
-	uint16_t cols;
-	uint16_t rows;
 	uint16_t cell_count;
+	uint8_t cell_cap;
+	uint8_t type;
+
+	// Sparse only: linear probing table, pool cells not in use
+	GridSlot *slots;
+	uint32_t slot_mask;
+	uint16_t occupied;
+
+	INT_N *free_cells;
+	uint16_t free_count;
+
+	GridStats stats;
 
 } Grid;
+
+// *
+// Where the grid goes and how it's tuned
+//
+// The grid is fitted to 'bounds' (level content plus a margin) with the configured cell size,
+// grown if that would need more than 'CELLS_MAX' cells. Fog of war and the static layer
+// keep that fitted layout for the whole level.
+//
+// Sparse grids ('type' set from the level) use the configured cell size as is and cover any position,
+// fog of war and the static layer still get the fitted layout.
+//
+// With auto-tune on, query work is sampled every 'GRID_TUNE_INTERVAL' ticks and the grid
+// alone is rebuilt over the same bounds when another cell size predicts clearly cheaper queries.
+// Cost is modelled from cells visited and entries tested, not measured time,
+// so decisions are the same on every machine running the same simulation.
+//
+// Replays pin the layouts and type they were recorded with, fitting then uses those as is.
+// *
+typedef struct {
+	// Settings, from config, 'type' from level
+	uint8_t type;
+	float cell_size;
+	Vector2 offset;		// Shift of origin from fitted bounds
+	uint8_t cell_cap;
+	bool auto_tune;
+
+	// Recorded fit, used instead of settings if 'pinned'
+	bool pinned;
+	uint8_t pinned_type;
+	CellLayout pinned_grid;
+	CellLayout pinned_level;
+
+	// Settings changed while running, grid is rebuilt with them on next 'GridTuneUpdate()'
+	bool refit;
+
+	Rectangle bounds;
+
+	uint32_t next_tick;
+
+	// Last decision, for the profiler
+	float query_cost;
+	uint16_t peak_entries;
+	uint16_t occupied_cells;
+	uint16_t retunes;
+
+} GridTuning;
+// ----------------------------------------
+
+// ----------------------------------------
+// 			   Selection 
+// ----------------------------------------
+#define CONTROL_GROUP_COUNT	10
+
+// Distance from unit center that still counts as clicking it
+#define SELECT_RADIUS		10
+
+// How a query combines with the current selection
+enum SELECT_MODES {
+	SELECT_REPLACE,
+	SELECT_ADD,
+	SELECT_REMOVE
+};
+
+// *
+// Selected units, kept in sync with the 'SELECTED' flag of their selectable components
+//
+// Ids are stored densely, 'index' maps an entity back to its slot,
+// so adding, removing and walking the selection all follow selection size.
+// Control groups are lists of entity ids, 'group_bits' marks which groups
+// an entity is in so killing it doesn't search every group.
+//
+// Selection and groups belong to the player, not the simulation:
+// snapshots don't store them, they are rebuilt from flags after loading.
+// *
+typedef struct {
+	INT_N *ids;
+	INT_N count;
+
+	// Slot in 'ids' per entity, -1 if not selected
+	INT_N *index;
+
+	vec_ent groups[CONTROL_GROUP_COUNT];
+	uint16_t *group_bits;
+
+} Selection;
+// ----------------------------------------
+
+// ----------------------------------------
+// 			   Snapshots 
+// ----------------------------------------
+#define SNAPSHOT_MAGIC		"SSNP"
+#define SNAPSHOT_VERSION	10
+
+// Snapshot blob header
+// Followed by: entities, component pools, order rings, projectiles,
+// grid cell coordinates (sparse grids only), grid cell counts, grid cell entries
+typedef struct {
+	char magic[4];
+	uint16_t version;
+
+	// Struct sizes at time of writing, blobs from other builds are rejected
+	// [entity, order, registered components...]
+	uint8_t layout[COMP_REGISTERED_COUNT + 2];
+
+	uint32_t size;
+	uint32_t tick;
+	uint64_t rng_state;
+
+	// Grid may have been retuned since level load, fog of war has to match the level
+	CellLayout grid_layout;
+	CellLayout vision_layout;
+	uint8_t grid_cell_cap;
+	uint8_t grid_type;
+
+	// Cells stored, all of them for dense grids, occupied ones for sparse
+	uint16_t grid_cells;
+
+	INT_N entity_count;
+	INT_N component_counts[COMP_REGISTERED_COUNT];
+
+	uint32_t projectile_count;
+
+	// Wave progress
+	float wave_timer;
+	uint16_t wave_current;
+	uint16_t wave_spawned;
+	uint16_t wave_count;
+
+} SnapshotHeader;
 // ----------------------------------------
 
 // Handler struct 
@@ -152,12 +518,50 @@ typedef struct {
 	
 	// Spatial grid struct
 	Grid grid;
+	GridTuning grid_tuning;
 
 	// Component mapping array	
 	ComponentMap *comp_mappings;
 
-	// Pointer to camera struct
-	Camera2D *camera;
+	// Ring buffers for all order components, 'ORDER_QUEUE_CAP' entries each
+	Order *order_queues;
+
+	// Projectile pool, not entities
+	Projectiles projectiles;
+
+	// Enemy waves from level
+	Waves waves;
+
+	// Scenery baked from level, not entities
+	StaticLayer statics;
+
+	// Fog of war for 'VISION_TEAM', laid out like the grid was fitted to the level
+	Visibility visibility;
+
+	// Player's selected units and control groups
+	Selection selection;
+
+	// Ids of killed entities, reused by 'AddEntity()'
+	uint64_t *free_entities;
+	INT_N free_entity_count;
+
+	// Recent visual effects, ring of 'RENDER_EFFECT_CAP'
+	// Output only, not part of simulation state
+	RenderEffect effects[RENDER_EFFECT_CAP];
+	uint32_t effect_count;
+
+	// Pointer to simulation arena, for buffers that only live until the next tick
+	Arena *arena;
+
+	// Simulation random number generator, seeded on init
+	Rng rng;
+
+	// Simulation tick counter
+	uint32_t tick;
+
+	// Bumped whenever all state is replaced (eg. snapshot load),
+	// systems caching derived data rebuild it when this changes
+	uint32_t change_epoch;
 
 	// Count and capacity for entity array:
 	INT_N entity_count; 
@@ -165,14 +569,62 @@ typedef struct {
 
 } Handler;
 
+// ----------------------------------------
+// 		    	Free Slot Bitmaps 
+// ----------------------------------------
+// Released entity and component ids are reused lowest first,
+// so which id a spawn gets only depends on which slots are free, never on the order they were freed in.
+// Snapshots can then rebuild free slots from live entities and stay deterministic.
+#define SLOT_WORDS(_cap) (((_cap) + 63) / 64)
+
+#define slot_set(_bits, _i)		((_bits)[(_i) / 64] |= (1ull << ((_i) % 64)))
+#define slot_clear(_bits, _i)	((_bits)[(_i) / 64] &= ~(1ull << ((_i) % 64)))
+#define slot_test(_bits, _i)	((_bits)[(_i) / 64] & (1ull << ((_i) % 64)))
+
+// Take lowest free slot, -1 if none
+static inline INT_N SlotsTakeLowest(uint64_t *bits, uint32_t words) {
+	for(uint32_t w = 0; w < words; w++) {
+		if(!bits[w]) continue;
+
+		INT_N i = w * 64 + __builtin_ctzll(bits[w]);
+		bits[w] &= bits[w] - 1;
+
+		return i;
+	}
+
+	return -1;
+}
+
+// Next set slot at or after 'from', -1 if none
+// eg. for(INT_N i = SlotsNext(bits, words, 0); i >= 0; i = SlotsNext(bits, words, i + 1))
+static inline INT_N SlotsNext(const uint64_t *bits, uint32_t words, INT_N from) {
+	uint32_t w = from / 64;
+	if(w >= words) return -1;
+
+	// Mask off bits below 'from' in first word
+	uint64_t word = bits[w] & (~0ull << (from % 64));
+
+	while(!word) {
+		if(++w >= words) return -1;
+		word = bits[w];
+	}
+
+	return w * 64 + __builtin_ctzll(word);
+}
+// ----------------------------------------
+
 // ----------------------------------------
 // 		    Component Pool Macros 
 // ----------------------------------------
 #define define_component_pool(_name, _type)	\
 typedef struct {	\
 	_type *data;	\
+	uint64_t *free_slots;	\
+	uint64_t *dirty;	\
+	INT_N *owners;	\
 	INT_N count;	\
 	INT_N capacity;	\
+	INT_N free_count;	\
 } _name;
 
 #define declare_component_pool(_name, _type)	\
@@ -183,65 +635,317 @@ typedef struct {	\
 		.capacity = COMP_CAP,	\
 	};	\
 	void _pool_##_name##_init() { \
-		_pool_##_name.data = calloc(COMP_CAP, sizeof(_type)); \
+		_pool_##_name.data = TrackedCalloc(COMP_CAP, sizeof(_type)); \
+		_pool_##_name.free_slots = TrackedCalloc(SLOT_WORDS(COMP_CAP), sizeof(uint64_t)); \
+		_pool_##_name.dirty = TrackedCalloc(SLOT_WORDS(COMP_CAP), sizeof(uint64_t)); \
+		_pool_##_name.owners = TrackedCalloc(COMP_CAP, sizeof(INT_N)); \
+		_pool_##_name.count = 0; \
+		_pool_##_name.free_count = 0; \
 	} \
 	INT_N _pool_##_name##_add(_type thing) { \
-		_pool_##_name.data[_pool_##_name.count] = thing;	\
-		return _pool_##_name.count++; \
+		INT_N id = (_pool_##_name.free_count) ? SlotsTakeLowest(_pool_##_name.free_slots, SLOT_WORDS(COMP_CAP)) : -1; \
+		if(id >= 0) _pool_##_name.free_count--; \
+		else id = _pool_##_name.count++; \
+		_pool_##_name.data[id] = thing;	\
+		return id; \
 	}	\
+	void _pool_##_name##_release(INT_N id) { \
+		_pool_##_name.data[id] = (_type) { 0 }; \
+		_pool_##_name.owners[id] = -1; \
+		slot_clear(_pool_##_name.dirty, id); \
+		slot_set(_pool_##_name.free_slots, id); \
+		_pool_##_name.free_count++; \
+	} \
+	INT_N _pool_##_name##_available() { \
+		return (COMP_CAP - _pool_##_name.count) + _pool_##_name.free_count; \
+	} \
+	void _pool_##_name##_mark_all_free() { \
+		memset(_pool_##_name.free_slots, 0, sizeof(uint64_t) * SLOT_WORDS(COMP_CAP)); \
+		for(INT_N i = 0; i < _pool_##_name.count; i++) slot_set(_pool_##_name.free_slots, i); \
+		_pool_##_name.free_count = _pool_##_name.count; \
+	} \
+	void _pool_##_name##_claim(INT_N id) { \
+		if(!slot_test(_pool_##_name.free_slots, id)) return; \
+		slot_clear(_pool_##_name.free_slots, id); \
+		_pool_##_name.free_count--; \
+	} \
 	_type* _pool_##_name##_get(INT_N id) { \
 		return &_pool_##_name.data[id]; \
 	} \
+	void *_pool_##_name##_ref(INT_N id) { \
+		return &_pool_##_name.data[id]; \
+	} \
+	void _pool_##_name##_mark_dirty(INT_N id) { \
+		slot_set(_pool_##_name.dirty, id); \
+	} \
+	void _pool_##_name##_clear_dirty() { \
+		memset(_pool_##_name.dirty, 0, sizeof(uint64_t) * SLOT_WORDS(_pool_##_name.count)); \
+	} \
+	void _pool_##_name##_mark_all_dirty() { \
+		for(INT_N i = 0; i < _pool_##_name.count; i++) slot_set(_pool_##_name.dirty, i); \
+	} \
 	void _pool_##_name##_free() { \
-		free(_pool_##_name.data);	\
+		TrackedFree(_pool_##_name.data);	\
+		TrackedFree(_pool_##_name.free_slots);	\
+		TrackedFree(_pool_##_name.dirty);	\
+		TrackedFree(_pool_##_name.owners);	\
 	}	\
-	void _pool_##_name##_bind_to(INT_N *mappings, uint32_t i) {	\
+	void _pool_##_name##_bind_to(INT_N *mappings, uint32_t i, INT_N entity_id) {	\
 		_type component = (_type) { 0 }; \
 		INT_N comp_id = _pool_##_name##_add(component); \
+		_pool_##_name.owners[comp_id] = entity_id; \
+		slot_set(_pool_##_name.dirty, comp_id); \
 		mappings[i] = comp_id;	\
+	}	\
+	void _pool_##_name##_bind_batch(Entity *entities, const INT_N *ids, INT_N count, uint32_t i, const void *defaults) {	\
+		for(INT_N k = 0; k < count; k++) {	\
+			INT_N comp_id = _pool_##_name##_add((_type) { 0 });	\
+			if(defaults) memcpy(&_pool_##_name.data[comp_id], defaults, sizeof(_type));	\
+			_pool_##_name.owners[comp_id] = ids[k];	\
+			slot_set(_pool_##_name.dirty, comp_id);	\
+			entities[ids[k]].comp_map.component_id[i] = comp_id;	\
+		}	\
 	}
+
+// Type-erased pool functions, one entry per registered component
+// Lets entity creation, lookup and snapshots loop over components instead of switching on them
+typedef struct {
+	char *name;
+	uint32_t size;
+
+	INT_N *count;
+
+	// Changed since start of tick, by component index
+	uint64_t **dirty;
+
+	// Entity using each component index
+	INT_N **owners;
+
+	void (*init)();
+	void (*free)();
+
+	void *(*ref)(INT_N id);
+
+	INT_N (*available)();
+	void (*release)(INT_N id);
+	void (*claim)(INT_N id);
+	void (*mark_all_free)();
+
+	void (*clear_dirty)();
+	void (*mark_all_dirty)();
+
+	void (*bind_to)(INT_N *mappings, uint32_t i, INT_N entity_id);
+	void (*bind_batch)(Entity *entities, const INT_N *ids, INT_N count, uint32_t i, const void *defaults);
+
+} ComponentType;
+
+#define comp_type_entry(_id, _field, _pool, _type)	\
+	[CI_##_id] = {	\
+		.name = #_field,	\
+		.size = sizeof(_type),	\
+		.count = &_pool_##_pool.count,	\
+		.dirty = &_pool_##_pool.dirty,	\
+		.owners = &_pool_##_pool.owners,	\
+		.init = _pool_##_pool##_init,	\
+		.free = _pool_##_pool##_free,	\
+		.ref = _pool_##_pool##_ref,	\
+		.available = _pool_##_pool##_available,	\
+		.release = _pool_##_pool##_release,	\
+		.claim = _pool_##_pool##_claim,	\
+		.mark_all_free = _pool_##_pool##_mark_all_free,	\
+		.clear_dirty = _pool_##_pool##_clear_dirty,	\
+		.mark_all_dirty = _pool_##_pool##_mark_all_dirty,	\
+		.bind_to = _pool_##_pool##_bind_to,	\
+		.bind_batch = _pool_##_pool##_bind_batch	\
+	},
+
+extern ComponentType component_types[COMP_REGISTERED_COUNT];
 // ----------------------------------------
 
 // Initalize handler:
 // Allocate memory for entity and component arrays,
 // set pointers, defaults, etc.
-void HandlerInit(Handler *handler, Camera2D *camera, float dt);
+void HandlerInit(Handler *handler, Arena *arena, uint64_t seed);
 
 void HandlerClose(Handler *handler);
 
 // Update all systems
+// Called once per simulation tick with a fixed 'dt', must not depend on wall-clock time
 void HandlerUpdate(Handler *handler, float dt);
 
-// Draw entities
-// *NOTE:
-// will be moved later to 'render.h',
-// sprite draw requests will be sent to renderer.
-// Renderer will process requests then draw them to buffer
-void HandlerDraw(Handler *handler);
+// Hash of simulation state, used to detect replay desyncs
+uint32_t HandlerChecksum(Handler *handler);
+
+// Serialize simulation state into a contiguous blob
+// 'HandlerSnapshotSize()' bytes must be available at 'dst'
+size_t HandlerSnapshotSize(Handler *handler);
+void HandlerSnapshotWrite(Handler *handler, uint8_t *dst);
+
+// Restore simulation state from blob, returns false if blob doesn't match this build or grid
+bool HandlerSnapshotRead(Handler *handler, const uint8_t *src, size_t size);
+
+// Record a visual effect for the renderer
+void HandlerPushEffect(Handler *handler, uint8_t type, Vector2 position);
+
+// Copy what the renderer needs into render state
+// Renderer only ever reads render states, never handler data
+void HandlerCaptureRenderState(Handler *handler, RenderState *state);
 
 // Create a new entity,
 // insert entity and it's components to respective arrays
 INT_N AddEntity(Handler *handler, uint32_t components);
 
-void SpawnEntity(Handler *handler, comp_Transform transform);
+// Create 'count' entities with the same components in one pass, writes their ids to 'ids'
+// 'defaults' holds initial data per component index, NULL entries are zeroed
+// Returns number created, less than 'count' if pools are full
+INT_N AddEntityBatch(Handler *handler, uint32_t components, const void **defaults, INT_N count, INT_N *ids);
+
+// Check 'count' entities with 'components' fit in entity array and component pools
+bool HandlerCanSpawn(Handler *handler, uint32_t components, INT_N count);
+
+// How many entities with 'components' still fit
+INT_N HandlerSpawnCapacity(Handler *handler, uint32_t components);
+
+// Remove entity from grid, release its components and id for reuse
+void KillEntity(Handler *handler, INT_N entity_id);
 
 INT_N TransformAdd(Handler *handler, comp_Transform comp_transform);
 void TransformsUpdate(Handler *handler, float dt);
 
 void SpritesUpdate(Handler *handler, float dt);
 
+// Move units towards their current order, advance queues on arrival
+void OrdersUpdate(Handler *handler, float dt);
+
+// Turn order targets into velocities, keeping units apart and away from obstacles
+// Neighbours are gathered from grid cells, 'STEER_MAX_NEIGHBOURS' at most
+void SteeringUpdate(Handler *handler, float dt);
+
+// Spawn due units of current wave, at most 'WAVE_SPAWN_BUDGET' per tick
+void WavesUpdate(Handler *handler, float dt);
+
+// Restamp vision of sources that changed cell, walks transforms changed since last tick
+void VisionUpdate(Handler *handler);
+
+// Keep turret targets valid, search for new ones when lost, fire when ready
+// Turrets of 'VISION_TEAM' ignore targets in cells it can't see
+void TurretsUpdate(Handler *handler, float dt);
+
+// Move projectiles, hit test the path covered this tick against grid cells it crosses
+void ProjectilesUpdate(Handler *handler, float dt);
+
+// Order queue access by orders component index
+Order *OrdersFront(Handler *handler, INT_N orders_id);
+Order *OrdersBack(Handler *handler, INT_N orders_id);
+bool OrdersPush(Handler *handler, INT_N orders_id, Order order);
+void OrdersPop(Handler *handler, INT_N orders_id);
+void OrdersClear(Handler *handler, INT_N orders_id);
+
+// Get pointer to an entity's component, NULL if entity doesn't have it
+void *HandlerGetComponent(Handler *handler, INT_N entity_id, uint32_t component);
+
+// *
+// Change tracking
+// Each pool keeps a dirty bit per component index, set when a component is created or written through
+// 'HandlerGetComponentMut()' (or '_pool_x_mark_dirty()' in systems that walk pools directly).
+// Bits are cleared right after the grid update at the start of a tick, so after 'HandlerUpdate()' they cover that tick.
+// Iterate with 'SlotsNext()' over 'component_types[CI_X].dirty', map indices to entities with '.owners'
+// *
+
+// Same as 'HandlerGetComponent()', marks the component changed
+void *HandlerGetComponentMut(Handler *handler, INT_N entity_id, uint32_t component);
+
+// Component changed this tick
+bool HandlerChanged(Handler *handler, INT_N entity_id, uint32_t component);
+
+void HandlerClearChanges(Handler *handler);
+void HandlerMarkAllChanged(Handler *handler);
+
 void PrintComponentMappings(Handler *handler, INT_N entity_id);
 void HandlerLogMessage(Handler *handler, char message[]);
 
-void CheckSelectedUnits(Handler *handler, Rectangle rec);
+void SelectionInit(Selection *sel);
+void SelectionClose(Selection *sel);
+
+// Deselect everything
+void SelectionClear(Handler *handler);
+
+// Entity must be selectable, returns false if nothing changed
+bool SelectionAdd(Handler *handler, INT_N entity_id);
+bool SelectionRemove(Handler *handler, INT_N entity_id);
+
+// Drop entity from selection and control groups, call before its components are released
+void SelectionForget(Handler *handler, INT_N entity_id);
+
+// Rebuild selection from component flags, drop dead entities from groups (eg. after snapshot load)
+void SelectionRebuild(Handler *handler);
+
+// Units inside rectangle (world space), found through the grid
+void SelectBox(Handler *handler, Rectangle rec, uint8_t mode);
+
+// Units sharing the sprite of the unit at 'point', inside 'view' (world space)
+void SelectSameType(Handler *handler, Vector2 point, Rectangle view, uint8_t mode);
+
+// Current selection becomes control group
+void GroupAssign(Handler *handler, uint8_t group);
+
+// Select control group
+void GroupRecall(Handler *handler, uint8_t group, uint8_t mode);
+
+// Append ids of all selected units to 'out'
+void GetSelectedUnits(Handler *handler, vec_ent *out);
 
-void GridInit(Grid *grid, Vector2 cell_size, uint16_t cols, uint16_t rows);
+// Sparse grids ignore 'layout' cols and rows
+void GridInit(Grid *grid, uint8_t type, CellLayout layout, uint8_t cell_cap);
 void GridClose(Grid *grid);
 void GridUpdate(Grid *grid, Handler *handler);
 
+// Add entity to cell at position, for entities placed without moving there
+void GridInsert(Grid *grid, INT_N entity_id, Vector2 position);
+
+// Remove entity from cell at position, sparse cells left empty go back to the pool
+void GridRemove(Grid *grid, INT_N entity_id, Vector2 position);
+
+// Remove entity id from cell, returns false if it wasn't there
+bool GridCellRemove(GridCell *cell, INT_N entity_id);
+
 int16_t GridCoordsToId(int16_t c, int16_t r, Grid *grid);
 bool IsCellInBounds(int16_t c, int16_t r, Grid *grid);
 
-void GridRenderDebugView(Grid *grid, Handler *handler);
+// Cell coordinates of position, false if a dense grid doesn't cover it
+bool GridCellCoords(Grid *grid, Vector2 position, int32_t *c, int32_t *r);
+
+// Cells overlapping rectangle (world space), counted in grid stats as one query
+// Clamped to the layout for dense grids, walk them with 'GridCellAt()'
+void GridQueryRange(Grid *grid, Rectangle rec, int32_t *col_start, int32_t *row_start, int32_t *col_end, int32_t *row_end);
+
+// Sparse cell at coordinates, NULL if nothing is there
+GridCell *GridSparseFind(Grid *grid, int32_t c, int32_t r);
+
+// Sparse cell at coordinates, taken from the pool if it isn't there yet
+GridCell *GridSparseAcquire(Grid *grid, int32_t c, int32_t r);
+
+// Return empty sparse cell to the pool
+void GridSparseRelease(Grid *grid, GridCell *cell);
+
+// Cell in range from 'GridQueryRange()', NULL if a sparse grid has nothing there
+static inline GridCell *GridCellAt(Grid *grid, int32_t c, int32_t r) {
+	if(grid->type == GRID_DENSE) return &grid->cells[c + r * grid->layout.cols];
+	return GridSparseFind(grid, c, r);
+}
+
+// Append ids of entities in cells overlapping rectangle (world space) to 'out'
+void GridQueryRec(Grid *grid, Rectangle rec, vec_ent *out);
+
+// Replace grid with a new layout, entities are reinserted in id order at their current position
+// Call right after 'GridUpdate()' or while positions match previous ones (eg. at load)
+void GridRebuild(Handler *handler, CellLayout layout);
+
+// Fit grid, fog of war and tuning area to world rectangle using settings in 'grid_tuning'
+// Static layer should be baked after, with 'visibility.layout'
+void HandlerFitGrid(Handler *handler, Rectangle bounds);
+
+// Auto-tune step, call after 'GridUpdate()' every tick, does nothing unless enabled or settings changed
+void GridTuneUpdate(Handler *handler);
 
 #endif
@@ -0,0 +1,34 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "input.h"
+
+void InputQueueInit(InputQueue *queue) {
+	queue->head = 0;
+	queue->tail = 0;
+}
+
+bool InputQueuePush(InputQueue *queue, InputEvent event) {
+	uint32_t tail = queue->tail;
+	uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+	if(tail - head >= INPUT_QUEUE_CAP) return false;
+
+	queue->events[tail & (INPUT_QUEUE_CAP - 1)] = event;
+
+	// Publish event after it's written
+	__atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+bool InputQueuePop(InputQueue *queue, InputEvent *event) {
+	uint32_t head = queue->head;
+	uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+
+	if(head == tail) return false;
+
+	*event = queue->events[head & (INPUT_QUEUE_CAP - 1)];
+
+	// Free slot after it's read
+	__atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
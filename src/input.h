@@ -0,0 +1,60 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "handler.h"
+
+#ifndef INPUT_H_
+#define INPUT_H_
+
+// Queue capacity, must be a power of two
+#define INPUT_QUEUE_CAP 256
+
+enum INPUT_EVENTS {
+	INPUT_SELECT,		// Select units in rectangle, 'flags' is a 'SELECT_MODES' value
+	INPUT_SELECT_TYPE,	// Select units like the one at order target, inside rectangle
+	INPUT_GROUP_ASSIGN,	// Selection becomes control group 'group'
+	INPUT_GROUP_SELECT,	// Select control group 'group'
+	INPUT_ORDER,		// Give order to selected units
+	INPUT_SAVE,			// Quick save
+	INPUT_LOAD,			// Quick load
+	INPUT_REWIND,		// Rewind 'amount' seconds
+	INPUT_BUILD,		// Place 'prefab' at order target
+	INPUT_TICK_RATE,	// Change simulation ticks per second to 'amount'
+	INPUT_GRID			// Rebuild grid with cells of side 'amount' holding 'cell_cap' entities
+};
+
+// Player action, forwarded from input handling to the simulation
+typedef struct {
+	Rectangle rec;		// World space
+	Order order;
+
+	float amount;
+
+	uint16_t prefab;
+	uint8_t group;
+	uint8_t cell_cap;
+	uint8_t type;
+	uint8_t flags;
+
+} InputEvent;
+
+// Single producer, single consumer lock-free ring
+// Producer: main thread, consumer: simulation (thread)
+typedef struct {
+	InputEvent events[INPUT_QUEUE_CAP];
+
+	// Free running counters, only producer writes 'tail', only consumer writes 'head'
+	uint32_t head;
+	uint32_t tail;
+
+} InputQueue;
+
+void InputQueueInit(InputQueue *queue);
+
+// Returns false if queue is full, event is dropped
+bool InputQueuePush(InputQueue *queue, InputEvent event);
+
+// Returns false if queue is empty
+bool InputQueuePop(InputQueue *queue, InputEvent *event);
+
+#endif
@@ -48,3 +48,26 @@ Rectangle ScaledRecWithCamera(Rectangle rec, Camera2D *camera) {
 	return rec;
 };
 
+void RngSeed(Rng *rng, uint64_t seed) {
+	// State must never be zero
+	rng->state = (seed) ? seed : 0x9E3779B97F4A7C15ull;
+}
+
+uint32_t RngNext(Rng *rng) {
+	uint64_t x = rng->state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	rng->state = x;
+
+	return (uint32_t)((x * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+float RngFloat(Rng *rng) {
+	// Use top 24 bits, exactly representable as float
+	return (RngNext(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+float RngRange(Rng *rng, float min, float max) {
+	return min + (max - min) * RngFloat(rng);
+}
@@ -1,3 +1,4 @@
+#include <stdint.h>
 #include "raylib.h"
 
 #ifndef KMATH_H_
@@ -11,4 +12,19 @@ Rectangle ScaledRec(Rectangle rec);
 Vector2 ScaledVec2WithCamera(Vector2 vec2, Camera2D *camera);
 Rectangle ScaledRecWithCamera(Rectangle rec, Camera2D *camera);
 
+// Seeded random number generator (xorshift64*)
+// Same seed always gives the same sequence, use for anything the simulation depends on
+typedef struct {
+	uint64_t state;
+} Rng;
+
+void RngSeed(Rng *rng, uint64_t seed);
+uint32_t RngNext(Rng *rng);
+
+// Random float in range [0, 1)
+float RngFloat(Rng *rng);
+
+// Random float in range [min, max)
+float RngRange(Rng *rng, float min, float max);
+
 #endif
@@ -0,0 +1,227 @@
+#include <stdint.h>
+#include <math.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "layers.h"
+#include "render.h"
+#include "game.h"
+
+typedef struct {
+	const char *path;
+	float factor;
+	float scale;
+} ParallaxDef;
+
+// Back to front
+ParallaxDef parallax_defs[PARALLAX_LAYER_COUNT] = {
+	[PARALLAX_SLOW]   = { "resources/graphics/background/slow.png",   0.05f, 2.0f },
+	[PARALLAX_MEDIUM] = { "resources/graphics/background/medium.png", 0.15f, 2.0f },
+	[PARALLAX_FAST]   = { "resources/graphics/background/fast.png",   0.3f,  2.0f }
+};
+
+// Tiles overlapping the view at current zoom level
+typedef struct {
+	int32_t col_start;
+	int32_t row_start;
+	int32_t col_end;
+	int32_t row_end;
+
+	// World units covered by one tile
+	float size;
+
+	int8_t level;
+
+} TileRange;
+
+void LayersInit(RenderLayers *layers) {
+	*layers = (RenderLayers) { 0 };
+
+	for(uint8_t i = 0; i < PARALLAX_LAYER_COUNT; i++) {
+		ParallaxLayer *layer = &layers->parallax[i];
+
+		layer->texture = LoadTexture(parallax_defs[i].path);
+		layer->factor = parallax_defs[i].factor;
+		layer->scale = parallax_defs[i].scale;
+
+		// Whole screen is covered by one quad, texture repeats across it
+		if(layer->texture.id) SetTextureWrap(layer->texture, TEXTURE_WRAP_REPEAT);
+	}
+}
+
+void LayersClose(RenderLayers *layers) {
+	for(uint8_t i = 0; i < PARALLAX_LAYER_COUNT; i++)
+		if(layers->parallax[i].texture.id) UnloadTexture(layers->parallax[i].texture);
+
+	for(uint8_t i = 0; i < LAYER_TILE_CACHE; i++)
+		if(layers->tiles[i].target.id) UnloadRenderTexture(layers->tiles[i].target);
+
+	*layers = (RenderLayers) { 0 };
+}
+
+static TileRange TilesInView(RenderStaticLayer *statics, Camera2D *camera) {
+	TileRange range;
+
+	// Nearest power of two to zoom, tiles keep roughly their pixel size on screen
+	range.level = Clamp(floorf(log2f(camera->zoom) + 0.5f), LAYER_LEVEL_MIN, LAYER_LEVEL_MAX);
+	range.size = LAYER_TILE_PX / ldexpf(1.0f, range.level);
+
+	Vector2 view_start = GetScreenToWorld2D(Vector2Zero(), *camera);
+	Vector2 view_end = GetScreenToWorld2D((Vector2){ VIRTUAL_WIDTH, VIRTUAL_HEIGHT }, *camera);
+
+	// Scenery can poke out of the level by its radius
+	Rectangle world = CellLayoutBounds(&statics->layout);
+
+	view_start.x = fmaxf(view_start.x, world.x - statics->max_radius);
+	view_start.y = fmaxf(view_start.y, world.y - statics->max_radius);
+	view_end.x = fminf(view_end.x, world.x + world.width + statics->max_radius);
+	view_end.y = fminf(view_end.y, world.y + world.height + statics->max_radius);
+
+	range.col_start = floorf(view_start.x / range.size);
+	range.row_start = floorf(view_start.y / range.size);
+	range.col_end = floorf(view_end.x / range.size);
+	range.row_end = floorf(view_end.y / range.size);
+
+	return range;
+}
+
+static Rectangle TileRec(int32_t x, int32_t y, float size) {
+	return (Rectangle) { .x = x * size, .y = y * size, .width = size, .height = size };
+}
+
+static StaticTile *TileFind(RenderLayers *layers, int32_t x, int32_t y, int8_t level) {
+	for(uint8_t i = 0; i < LAYER_TILE_CACHE; i++) {
+		StaticTile *tile = &layers->tiles[i];
+
+		if(tile->valid && tile->x == x && tile->y == y && tile->level == level)
+			return tile;
+	}
+
+	return NULL;
+}
+
+// Free or least recently drawn tile, NULL if all are in view
+static StaticTile *TileEvict(RenderLayers *layers) {
+	StaticTile *oldest = NULL;
+
+	for(uint8_t i = 0; i < LAYER_TILE_CACHE; i++) {
+		StaticTile *tile = &layers->tiles[i];
+
+		if(!tile->valid) return tile;
+		if(tile->last_used == layers->frame) continue;
+
+		if(!oldest || tile->last_used < oldest->last_used) oldest = tile;
+	}
+
+	return oldest;
+}
+
+static void TileRender(StaticTile *tile, RenderStaticLayer *statics, int32_t x, int32_t y, TileRange *range) {
+	if(!tile->target.id) {
+		tile->target = LoadRenderTexture(LAYER_TILE_PX, LAYER_TILE_PX);
+		SetTextureFilter(tile->target.texture, TEXTURE_FILTER_BILINEAR);
+	}
+
+	Rectangle rec = TileRec(x, y, range->size);
+
+	Camera2D camera = (Camera2D) {
+		.target = (Vector2) { rec.x, rec.y },
+		.zoom = LAYER_TILE_PX / range->size
+	};
+
+	BeginTextureMode(tile->target);
+	ClearBackground(BLANK);
+
+	BeginMode2D(camera);
+	RenderStaticsDraw(statics, rec);
+	EndMode2D();
+
+	EndTextureMode();
+
+	tile->x = x;
+	tile->y = y;
+	tile->level = range->level;
+	tile->valid = true;
+}
+
+void LayersPrepare(RenderLayers *layers, RenderStaticLayer *statics, Camera2D *camera) {
+	layers->frame++;
+
+	// Level changed, every tile is stale
+	if(statics->items != layers->source || statics->count != layers->source_count) {
+		for(uint8_t i = 0; i < LAYER_TILE_CACHE; i++)
+			layers->tiles[i].valid = false;
+
+		layers->source = statics->items;
+		layers->source_count = statics->count;
+	}
+
+	if(!statics->count) return;
+
+	TileRange range = TilesInView(statics, camera);
+
+	// Mark tiles in view first so they aren't evicted below
+	for(int32_t y = range.row_start; y <= range.row_end; y++) {
+		for(int32_t x = range.col_start; x <= range.col_end; x++) {
+			StaticTile *tile = TileFind(layers, x, y, range.level);
+			if(tile) tile->last_used = layers->frame;
+		}
+	}
+
+	// Render missing ones, limited per frame so panning doesn't spike
+	uint8_t budget = LAYER_TILES_PER_FRAME;
+
+	for(int32_t y = range.row_start; y <= range.row_end && budget; y++) {
+		for(int32_t x = range.col_start; x <= range.col_end && budget; x++) {
+			if(TileFind(layers, x, y, range.level)) continue;
+
+			StaticTile *tile = TileEvict(layers);
+			if(!tile) return;
+
+			TileRender(tile, statics, x, y, &range);
+			tile->last_used = layers->frame;
+			budget--;
+		}
+	}
+}
+
+void LayersDrawBackground(RenderLayers *layers, Camera2D *camera) {
+	for(uint8_t i = 0; i < PARALLAX_LAYER_COUNT; i++) {
+		ParallaxLayer *layer = &layers->parallax[i];
+		if(!layer->texture.id) continue;
+
+		// Scroll in texture pixels, source rect past the texture edge wraps
+		Rectangle src = (Rectangle) {
+			.x = camera->target.x * camera->zoom * layer->factor / layer->scale,
+			.y = camera->target.y * camera->zoom * layer->factor / layer->scale,
+			.width = VIRTUAL_WIDTH / layer->scale,
+			.height = VIRTUAL_HEIGHT / layer->scale
+		};
+
+		Rectangle dest = (Rectangle) { 0, 0, VIRTUAL_WIDTH, VIRTUAL_HEIGHT };
+
+		DrawTexturePro(layer->texture, src, dest, Vector2Zero(), 0, WHITE);
+	}
+}
+
+void LayersDrawStatics(RenderLayers *layers, RenderStaticLayer *statics, Camera2D *camera) {
+	if(!statics->count) return;
+
+	TileRange range = TilesInView(statics, camera);
+
+	for(int32_t y = range.row_start; y <= range.row_end; y++) {
+		for(int32_t x = range.col_start; x <= range.col_end; x++) {
+			Rectangle rec = TileRec(x, y, range.size);
+			StaticTile *tile = TileFind(layers, x, y, range.level);
+
+			// Not cached yet, draw directly this frame
+			if(!tile) {
+				RenderStaticsDraw(statics, rec);
+				continue;
+			}
+
+			// Render textures are stored upside down
+			Rectangle src = (Rectangle) { 0, 0, LAYER_TILE_PX, -LAYER_TILE_PX };
+			DrawTexturePro(tile->target.texture, src, rec, Vector2Zero(), 0, WHITE);
+		}
+	}
+}
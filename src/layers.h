@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "render.h"
+
+#ifndef LAYERS_H_
+#define LAYERS_H_
+
+// Size of a cached static tile texture in pixels
+#define LAYER_TILE_PX			512
+
+// Tile textures kept around, enough for the view plus a ring around it
+#define LAYER_TILE_CACHE		24
+
+// Tiles rendered per frame, missing tiles are drawn directly until cached
+#define LAYER_TILES_PER_FRAME	4
+
+// Zoom is snapped to powers of two, tiles are re-rendered when it crosses one
+#define LAYER_LEVEL_MIN			-3
+#define LAYER_LEVEL_MAX			2
+
+enum PARALLAX_LAYERS {
+	PARALLAX_SLOW,
+	PARALLAX_MEDIUM,
+	PARALLAX_FAST,
+	PARALLAX_LAYER_COUNT
+};
+
+typedef struct {
+	Texture2D texture;
+
+	// Fraction of camera movement the layer follows, lower is further away
+	float factor;
+
+	// Texture pixels to screen pixels
+	float scale;
+
+} ParallaxLayer;
+
+typedef struct {
+	RenderTexture2D target;
+
+	// Tile coordinates at 'level'
+	int32_t x;
+	int32_t y;
+	int8_t level;
+
+	bool valid;
+
+	// Frame tile was last drawn, oldest gets replaced first
+	uint32_t last_used;
+
+} StaticTile;
+
+// *
+// Render cache for everything that doesn't move
+//
+// Background is a few parallax textures with wrapping enabled,
+// each drawn as a single quad scrolled by the camera.
+// Static scenery is rendered once into tiles covering a fixed region of the world,
+// drawing the asteroid field is then one textured quad per visible tile.
+// Tiles are keyed by position and zoom level, so they only get redrawn when
+// a new region comes into view or zoom crosses a power of two.
+// *
+typedef struct {
+	ParallaxLayer parallax[PARALLAX_LAYER_COUNT];
+
+	StaticTile tiles[LAYER_TILE_CACHE];
+
+	// Static layer tiles were rendered from, cache is flushed when it changes
+	const RenderStatic *source;
+	uint32_t source_count;
+
+	uint32_t frame;
+
+} RenderLayers;
+
+// Needs graphics context
+void LayersInit(RenderLayers *layers);
+void LayersClose(RenderLayers *layers);
+
+// Render missing tiles in view, call outside of texture mode
+void LayersPrepare(RenderLayers *layers, RenderStaticLayer *statics, Camera2D *camera);
+
+// Parallax background in screen space, call before 'BeginMode2D'
+void LayersDrawBackground(RenderLayers *layers, Camera2D *camera);
+
+// Cached static tiles, call inside 'BeginMode2D'
+void LayersDrawStatics(RenderLayers *layers, RenderStaticLayer *statics, Camera2D *camera);
+
+#endif
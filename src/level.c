@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <string.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "level.h"
+#include "handler.h"
+#include "waves.h"
+#include "prefabs.h"
+#include "statics.h"
+
+#define streq(a, b) (strcmp((a), (b)) == 0)
+
+enum LEVEL_BLOCKS {
+	BLOCK_NONE,
+	BLOCK_WAVE,
+	BLOCK_ASTEROID,
+	BLOCK_BOUNDS,
+	BLOCK_GRID
+};
+
+// Corners of an area, grown point by point
+typedef struct {
+	Vector2 min;
+	Vector2 max;
+	bool set;
+
+} LevelExtent;
+
+// Grow extent to include circle
+static void ExtentAdd(LevelExtent *extent, Vector2 center, float radius) {
+	Vector2 min = (Vector2) { center.x - radius, center.y - radius };
+	Vector2 max = (Vector2) { center.x + radius, center.y + radius };
+
+	extent->min = (extent->set) ? Vector2Min(extent->min, min) : min;
+	extent->max = (extent->set) ? Vector2Max(extent->max, max) : max;
+	extent->set = true;
+}
+
+static Rectangle ExtentRec(LevelExtent *extent) {
+	return (Rectangle) { extent->min.x, extent->min.y, extent->max.x - extent->min.x, extent->max.y - extent->min.y };
+}
+
+// Area covered by level content and units already in the world, padded by 'GRID_LEVEL_MARGIN'
+static Rectangle LevelContentBounds(Handler *handler, vec_static *statics) {
+	LevelExtent extent = { 0 };
+
+	for(size_t i = 0; i < statics->count; i++) 
+		ExtentAdd(&extent, statics->data[i].position, statics->data[i].radius);
+
+	Waves *waves = &handler->waves;
+
+	for(size_t i = 0; i < waves->defs.count; i++) {
+		ExtentAdd(&extent, waves->defs.data[i].spawn, waves->defs.data[i].spread);
+		ExtentAdd(&extent, waves->defs.data[i].target, 0);
+	}
+
+	for(INT_N i = 0; i < handler->entity_count; i++) {
+		comp_Transform *transform = HandlerGetComponent(handler, i, COMP_TRANSFORM);
+		if(transform) ExtentAdd(&extent, transform->position, 0);
+	}
+
+	// Empty level keeps the grid area it had
+	if(!extent.set) return handler->grid_tuning.bounds;
+
+	ExtentAdd(&extent, extent.min, GRID_LEVEL_MARGIN);
+	ExtentAdd(&extent, extent.max, GRID_LEVEL_MARGIN);
+
+	return ExtentRec(&extent);
+}
+
+// Parse one 'key: value' line of a wave block
+static void LevelParseWave(WaveDef *wave, char *key, char *val) {
+	if(streq(key, "unit")) {
+		int16_t prefab = PrefabFind(val);
+
+		if(prefab < 0) printf("ERROR: Unknown unit in wave: %s\n", val);
+		else wave->prefab = prefab;
+
+	} else if(streq(key, "count")) {
+		sscanf(val, "%hu", &wave->count);
+
+	} else if(streq(key, "interval")) {
+		sscanf(val, "%f", &wave->interval);
+
+	} else if(streq(key, "delay")) {
+		sscanf(val, "%f", &wave->delay);
+
+	} else if(streq(key, "spawn")) {
+		sscanf(val, "%f, %f", &wave->spawn.x, &wave->spawn.y);
+
+	} else if(streq(key, "spread")) {
+		sscanf(val, "%f", &wave->spread);
+
+	} else if(streq(key, "target")) {
+		sscanf(val, "%f, %f", &wave->target.x, &wave->target.y);
+	}
+}
+
+// Parse one 'key: value' line of an asteroid block
+// Size comes from the asteroid prefab, scaled
+static void LevelParseAsteroid(StaticDef *def, char *key, char *val) {
+	if(streq(key, "position")) {
+		sscanf(val, "%f, %f", &def->position.x, &def->position.y);
+
+	} else if(streq(key, "scale")) {
+		float scale = 1;
+		sscanf(val, "%f", &scale);
+
+		def->radius = prefabs[PREFAB_ASTEROID].obstacle.radius * scale;
+
+	} else if(streq(key, "rotation")) {
+		sscanf(val, "%f", &def->rotation);
+	}
+}
+
+bool LevelLoad(Handler *handler, char *path) {
+	FILE *pF = fopen(path, "r");
+
+	if(!pF) {
+		printf("ERROR: Could not open level file at: %s\n", path);
+		return false;
+	}
+
+	Waves *waves = &handler->waves;
+	vec_wave_clear(&waves->defs);
+
+	uint8_t block = BLOCK_NONE;
+	WaveDef *wave = NULL;
+
+	// Static objects, baked once whole file is read
+	vec_static statics;
+	vec_static_init(&statics, 64);
+
+	// Grid area given by level, if any
+	LevelExtent bounds = { 0 };
+
+	// Dense grid unless level asks otherwise
+	handler->grid_tuning.type = GRID_DENSE;
+
+	char line[128];
+	while(fgets(line, sizeof(line), pF)) {
+		char *n = strchr(line, '\n');
+		if(n) *n = '\0';
+
+		// Block header
+		if(line[0] == '[') {
+			block = BLOCK_NONE;
+
+			if(streq(line, "[wave]")) {
+				block = BLOCK_WAVE;
+				size_t i = vec_wave_push(&waves->defs, (WaveDef) { .prefab = PREFAB_DRONE });
+				wave = &waves->defs.data[i];
+
+			} else if(streq(line, "[asteroid]")) {
+				block = BLOCK_ASTEROID;
+				vec_static_push(&statics, (StaticDef) {
+					.radius = prefabs[PREFAB_ASTEROID].obstacle.radius,
+					.sprite_id = prefabs[PREFAB_ASTEROID].sprite.sprite_id
+				});
+
+			} else if(streq(line, "[bounds]")) {
+				block = BLOCK_BOUNDS;
+
+			} else if(streq(line, "[grid]")) {
+				block = BLOCK_GRID;
+			}
+
+			continue;
+		}
+
+		// Split key and value
+		char *sep = strstr(line, ": ");
+		if(!sep) continue;
+
+		*sep = '\0';
+		char *key = line;
+		char *val = sep + 2;
+
+		if(block == BLOCK_WAVE) LevelParseWave(wave, key, val);
+		else if(block == BLOCK_ASTEROID) LevelParseAsteroid(&statics.data[statics.count - 1], key, val);
+		else if(block == BLOCK_BOUNDS) {
+			Vector2 corner = { 0 };
+			if(sscanf(val, "%f, %f", &corner.x, &corner.y) == 2 && (streq(key, "min") || streq(key, "max")))
+				ExtentAdd(&bounds, corner, 0);
+
+		} else if(block == BLOCK_GRID && streq(key, "type")) {
+			if(streq(val, "sparse")) handler->grid_tuning.type = GRID_SPARSE;
+			else if(streq(val, "dense")) handler->grid_tuning.type = GRID_DENSE;
+			else printf("WARNING: Unknown grid type '%s' in level, using dense\n", val);
+		}
+	}
+
+	fclose(pF);
+
+	WavesReset(waves);
+
+	// Grid and fog of war over the level, scenery is binned into the same cells
+	HandlerFitGrid(handler, (bounds.set) ? ExtentRec(&bounds) : LevelContentBounds(handler, &statics));
+	StaticLayerBake(&handler->statics, statics.data, statics.count, handler->visibility.layout);
+	vec_static_free(&statics);
+
+	printf("level: %zu waves, %d static objects\n", waves->defs.count, handler->statics.count);
+
+	return true;
+}
+
+// FNV-1a
+uint32_t LevelHash(char *path) {
+	FILE *pF = fopen(path, "rb");
+	if(!pF) return 0;
+
+	uint32_t hash = 2166136261u;
+
+	int c;
+	while((c = fgetc(pF)) != EOF) {
+		hash ^= (uint8_t)c;
+		hash *= 16777619u;
+	}
+
+	fclose(pF);
+
+	return hash;
+}
@@ -0,0 +1,42 @@
+#include <stdbool.h>
+#include "handler.h"
+
+#ifndef LEVEL_H_
+#define LEVEL_H_
+
+// *
+// Level files are a list of blocks, each a '[type]' line followed by 'key: value' lines
+//
+// eg.
+// [wave]
+// unit: drone
+// count: 200
+// interval: 0.05
+// delay: 10
+// spawn: 6000, 300
+// spread: 150
+// target: 6000, 6000
+//
+// [asteroid] blocks go to the static layer, sized from the asteroid prefab times 'scale'
+//
+// Grid and fog of war are fitted to everything the level places (waves, scenery, units already spawned)
+// plus 'GRID_LEVEL_MARGIN', or to a [bounds] block if there is one:
+// [bounds]
+// min: -2000, -2000
+// max: 20000, 12000
+//
+// Levels that spread far or without bounds can use a sparse grid, it covers any position
+// and allocates cells only where entities are. Fog of war and scenery still use the fitted area.
+// [grid]
+// type: sparse
+//
+// Block types without a loader are skipped
+// *
+
+// Read level file into handler, false if file can't be opened
+bool LevelLoad(Handler *handler, char *path);
+
+// Hash of level file contents, 0 if file can't be opened
+uint32_t LevelHash(char *path);
+
+#endif
@@ -1,9 +1,31 @@
 #include <stdio.h>
+#include <string.h>
 #include "raylib.h"
 #include "config.h"
 #include "game.h"
  
-int main() {
+int main(int argc, char **argv) {
+	Game game = {0};
+
+	// Command line options:
+	// --record <file>	record session to replay file
+	// --replay <file>	play replay without a window, as fast as possible
+	// --load <file>	start from saved state
+	for(int i = 1; i + 1 < argc; i++) {
+		if(streq(argv[i], "--record")) game.record_path = argv[++i];
+		else if(streq(argv[i], "--replay")) game.replay_path = argv[++i];
+		else if(streq(argv[i], "--load")) game.load_path = argv[++i];
+	}
+
+	// Headless replay, simulation only
+	if(game.replay_path) {
+		GameInit(&game);
+		int result = SimRunHeadless(&game.sim, &game.handler, &game.commands);
+		GameClose(&game);
+
+		return result;
+	}
+
 	// Initialize audio backend
 	InitAudioDevice();
 	SetMasterVolume(1);
@@ -13,7 +35,6 @@ int main() {
 
 	// Initialize game
 	// Set window options, instantiate objects, allocate memory, etc.
-	Game game = {0};
 	GameInit(&game);
 
 	// Open window, use values from config file
@@ -29,6 +50,9 @@ int main() {
 	// Load game assets: spritesheets, audio, etc.
 	GameContentInit(&game);
 
+	// Start simulation thread, if enabled
+	GameSimStart(&game);
+
 	//SetExitKey(KEY_F10);	
 	bool exit = false;
 
@@ -0,0 +1,169 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory.h"
+
+MemStats mem_stats = { 0 };
+
+// Counters are updated from both main and simulation threads
+#define stat_add(_field, _val) __atomic_fetch_add(&mem_stats._field, (_val), __ATOMIC_RELAXED)
+
+// Round size up to a multiple of alignment (alignment must be a power of two)
+static size_t AlignUp(size_t size, size_t alignment) {
+	return (size + (alignment - 1)) & ~(alignment - 1);
+}
+
+void *TrackedMalloc(size_t size) {
+	stat_add(heap_allocs, 1);
+	stat_add(frame_heap_allocs, 1);
+	stat_add(heap_bytes, size);
+
+	return malloc(size);
+}
+
+void *TrackedCalloc(size_t count, size_t size) {
+	stat_add(heap_allocs, 1);
+	stat_add(frame_heap_allocs, 1);
+	stat_add(heap_bytes, count * size);
+
+	return calloc(count, size);
+}
+
+void *TrackedRealloc(void *ptr, size_t size) {
+	stat_add(heap_allocs, 1);
+	stat_add(frame_heap_allocs, 1);
+	stat_add(heap_bytes, size);
+
+	return realloc(ptr, size);
+}
+
+void TrackedFree(void *ptr) {
+	if(!ptr) return;
+
+	stat_add(heap_frees, 1);
+	free(ptr);
+}
+
+void MemStatsBeginFrame() {
+	mem_stats.last_frame_heap_allocs = __atomic_exchange_n(&mem_stats.frame_heap_allocs, 0, __ATOMIC_RELAXED);
+}
+
+// ----------------------------------------
+// 			  Linear Arena
+// ----------------------------------------
+void ArenaInit(Arena *arena, size_t capacity) {
+	capacity = AlignUp(capacity, ARENA_ALIGN);
+
+	*arena = (Arena) {
+		.data = TrackedMalloc(capacity),
+		.overflow = NULL,
+		.overflow_bytes = 0,
+		.capacity = capacity,
+		.offset = 0,
+		.peak = 0
+	};
+}
+
+// Free overflow chunks newer than 'stop'
+static void ArenaFreeOverflow(Arena *arena, ArenaChunk *stop) {
+	while(arena->overflow && arena->overflow != stop) {
+		ArenaChunk *next = arena->overflow->next;
+		arena->overflow_bytes -= arena->overflow->offset;
+
+		TrackedFree(arena->overflow);
+		arena->overflow = next;
+	}
+}
+
+void ArenaClose(Arena *arena) {
+	ArenaFreeOverflow(arena, NULL);
+	TrackedFree(arena->data);
+
+	*arena = (Arena) { 0 };
+}
+
+void *ArenaAlloc(Arena *arena, size_t size) {
+	size = AlignUp(size, ARENA_ALIGN);
+
+	// Fast path, bump main block
+	if(!arena->overflow && arena->offset + size <= arena->capacity) {
+		void *ptr = arena->data + arena->offset;
+		arena->offset += size;
+
+		return ptr;
+	}
+
+	// Main block is full, bump newest overflow chunk
+	ArenaChunk *chunk = arena->overflow;
+	size_t header = AlignUp(sizeof(ArenaChunk), ARENA_ALIGN);
+
+	if(!chunk || chunk->offset + size > chunk->capacity) {
+		// Chain a new chunk, at least as large as the main block
+		size_t capacity = (size > arena->capacity) ? size : arena->capacity;
+
+		chunk = TrackedMalloc(header + capacity);
+		chunk->next = arena->overflow;
+		chunk->capacity = capacity;
+		chunk->offset = 0;
+
+		arena->overflow = chunk;
+	}
+
+	void *ptr = (uint8_t*)chunk + header + chunk->offset;
+	chunk->offset += size;
+	arena->overflow_bytes += size;
+
+	return ptr;
+}
+
+void *ArenaCalloc(Arena *arena, size_t count, size_t size) {
+	void *ptr = ArenaAlloc(arena, count * size);
+	memset(ptr, 0, count * size);
+
+	return ptr;
+}
+
+void ArenaReset(Arena *arena) {
+	size_t used = ArenaUsed(arena);
+	if(used > arena->peak) arena->peak = used;
+
+	// Grow main block to fit the whole frame,
+	// following frames won't need to chain chunks
+	if(arena->overflow) {
+		ArenaFreeOverflow(arena, NULL);
+
+		size_t capacity = arena->capacity;
+		while(capacity < arena->peak) capacity *= 2;
+
+		TrackedFree(arena->data);
+		arena->data = TrackedMalloc(capacity);
+		arena->capacity = capacity;
+	}
+
+	arena->offset = 0;
+}
+
+ArenaMark ArenaGetMark(Arena *arena) {
+	return (ArenaMark) {
+		.overflow = arena->overflow,
+		.overflow_bytes = arena->overflow_bytes,
+		.offset = arena->offset,
+		.chunk_offset = (arena->overflow) ? arena->overflow->offset : 0
+	};
+}
+
+void ArenaRewind(Arena *arena, ArenaMark mark) {
+	size_t used = ArenaUsed(arena);
+	if(used > arena->peak) arena->peak = used;
+
+	ArenaFreeOverflow(arena, mark.overflow);
+
+	if(arena->overflow) arena->overflow->offset = mark.chunk_offset;
+	arena->overflow_bytes = mark.overflow_bytes;
+	arena->offset = mark.offset;
+}
+
+size_t ArenaUsed(Arena *arena) {
+	return arena->offset + arena->overflow_bytes;
+}
+// ----------------------------------------
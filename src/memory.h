@@ -0,0 +1,94 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MEMORY_H_
+#define MEMORY_H_
+
+// Default size of the per-frame arena,
+// grows on reset if a frame ever needed more
+#define FRAME_ARENA_SIZE	(1024 * 1024)
+
+// Alignment of every arena allocation
+#define ARENA_ALIGN			16
+
+// Heap allocation counters, updated by the Tracked* functions
+typedef struct {
+	uint32_t heap_allocs;			// Allocations since startup
+	uint32_t heap_frees;			// Frees since startup
+	uint32_t frame_heap_allocs;		// Allocations made during the current frame
+	uint32_t last_frame_heap_allocs;// Allocations made during the previous frame
+
+	size_t heap_bytes;				// Bytes requested from the heap since startup
+
+} MemStats;
+
+extern MemStats mem_stats;
+
+// Heap wrappers, same semantics as their libc counterparts but counted in 'mem_stats'
+void *TrackedMalloc(size_t size);
+void *TrackedCalloc(size_t count, size_t size);
+void *TrackedRealloc(void *ptr, size_t size);
+void TrackedFree(void *ptr);
+
+// Mark the start of a new frame in the allocation counters
+void MemStatsBeginFrame();
+
+// ----------------------------------------
+// 			  Linear Arena
+// ----------------------------------------
+// Extra chunk chained onto an arena when it runs out of space,
+// chunk data follows the header
+typedef struct ArenaChunk {
+	struct ArenaChunk *next;
+	size_t capacity;
+	size_t offset;
+
+} ArenaChunk;
+
+// Bump allocator, everything allocated is released at once with 'ArenaReset()'
+typedef struct {
+	uint8_t *data;
+
+	// Chunks allocated this frame after 'data' ran out
+	ArenaChunk *overflow;
+	size_t overflow_bytes;
+
+	size_t capacity;
+	size_t offset;
+
+	// Most bytes handed out between two resets
+	size_t peak;
+
+} Arena;
+
+// Saved arena position, used to release temporary allocations early
+typedef struct {
+	ArenaChunk *overflow;
+	size_t overflow_bytes;
+	size_t offset;
+	size_t chunk_offset;
+
+} ArenaMark;
+
+void ArenaInit(Arena *arena, size_t capacity);
+void ArenaClose(Arena *arena);
+
+// Allocate uninitialized memory, never returns NULL
+void *ArenaAlloc(Arena *arena, size_t size);
+
+// Allocate zeroed memory
+void *ArenaCalloc(Arena *arena, size_t count, size_t size);
+
+// Release everything, grow main block if the last frame overflowed
+void ArenaReset(Arena *arena);
+
+ArenaMark ArenaGetMark(Arena *arena);
+void ArenaRewind(Arena *arena, ArenaMark mark);
+
+// Bytes currently handed out
+size_t ArenaUsed(Arena *arena);
+
+#define ArenaPushArray(_arena, _type, _count) ((_type*)ArenaAlloc((_arena), sizeof(_type) * (_count)))
+// ----------------------------------------
+
+#endif
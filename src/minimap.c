@@ -0,0 +1,125 @@
+#include <stdint.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "minimap.h"
+#include "render.h"
+#include "game.h"
+#include "memory.h"
+
+void MinimapInit(Minimap *minimap, CellLayout layout, Rectangle bounds) {
+	uint32_t cell_count = layout.cols * layout.rows;
+	uint8_t *memory = TrackedCalloc(cell_count, sizeof(int16_t) + sizeof(uint8_t));
+
+	*minimap = (Minimap) {
+		.counts = (int16_t*)memory,
+		.teams = memory + sizeof(int16_t) * cell_count,
+		.layout = layout,
+		.bounds = bounds,
+		.tick = UINT32_MAX,
+		.memory = memory
+	};
+
+	// Starts empty, like the zeroed cell copies
+	CellTextureInit(&minimap->texture, layout.cols, layout.rows);
+}
+
+void MinimapClose(Minimap *minimap) {
+	CellTextureClose(&minimap->texture);
+	TrackedFree(minimap->memory);
+
+	*minimap = (Minimap) { 0 };
+}
+
+static Color MinimapCellColor(int16_t count, uint8_t teams) {
+	// No teams means only enemies in fog
+	if(count <= 0 || !teams) return BLANK;
+
+	Color color = GRAY;
+	teams &= ~RENDER_TEAM_NEUTRAL;
+
+	if(teams == 0x01) color = SKYBLUE;
+	else if(teams == 0x02) color = RED;
+	else if(teams) color = YELLOW;	// Contested
+
+	// Denser cells are brighter
+	float density = Clamp(count / 8.0f, 0, 1);
+	return ColorAlpha(color, 0.4f + 0.6f * density);
+}
+
+void MinimapUpdate(Minimap *minimap, RenderState *state) {
+	if(!minimap->memory || state->tick == minimap->tick || !state->layout.cols) return;
+
+	if(!CellLayoutEqual(&state->layout, &minimap->layout)) {
+		Rectangle bounds = minimap->bounds;
+
+		MinimapClose(minimap);
+		MinimapInit(minimap, state->layout, bounds);
+	}
+
+	minimap->tick = state->tick;
+
+	CellLayout *layout = &minimap->layout;
+
+	// Rebuild pixels of changed cells only
+	for(uint16_t r = 0; r < layout->rows; r++) {
+		for(uint16_t c = 0; c < layout->cols; c++) {
+			uint32_t i = c + r * layout->cols;
+
+			int16_t count = state->cell_counts[i];
+			uint8_t teams = state->cell_teams[i];
+
+			if(count == minimap->counts[i] && teams == minimap->teams[i]) continue;
+
+			minimap->counts[i] = count;
+			minimap->teams[i] = teams;
+			CellTextureSet(&minimap->texture, c, r, MinimapCellColor(count, teams));
+		}
+	}
+
+	CellTextureUpload(&minimap->texture);
+}
+
+void MinimapDraw(Minimap *minimap, Camera2D *camera) {
+	if(!minimap->texture.texture.id) return;
+
+	Rectangle bounds = minimap->bounds;
+	Rectangle world = CellLayoutBounds(&minimap->layout);
+	Rectangle src = (Rectangle) { 0, 0, minimap->layout.cols, minimap->layout.rows };
+
+	DrawRectangleRec(bounds, ColorAlpha(BLACK, 0.6f));
+	DrawTexturePro(minimap->texture.texture, src, bounds, Vector2Zero(), 0, WHITE);
+	DrawRectangleLinesEx(bounds, 1, DARKGRAY);
+
+	// Camera view outline, clipped to map
+	Vector2 view_start = GetScreenToWorld2D(Vector2Zero(), *camera);
+	Vector2 view_end = GetScreenToWorld2D((Vector2){ VIRTUAL_WIDTH, VIRTUAL_HEIGHT }, *camera);
+
+	Vector2 scale = (Vector2) {
+		.x = bounds.width / world.width,
+		.y = bounds.height / world.height
+	};
+
+	Rectangle view = (Rectangle) {
+		.x = bounds.x + (view_start.x - world.x) * scale.x,
+		.y = bounds.y + (view_start.y - world.y) * scale.y,
+		.width = (view_end.x - view_start.x) * scale.x,
+		.height = (view_end.y - view_start.y) * scale.y
+	};
+
+	view = GetCollisionRec(view, bounds);
+	if(view.width > 0 && view.height > 0) DrawRectangleLinesEx(view, 1, RAYWHITE);
+}
+
+bool MinimapContains(Minimap *minimap, Vector2 window_position) {
+	return minimap->texture.texture.id && CheckCollisionPointRec(window_position, minimap->bounds);
+}
+
+Vector2 MinimapToWorld(Minimap *minimap, Vector2 window_position) {
+	Rectangle bounds = minimap->bounds;
+	Rectangle world = CellLayoutBounds(&minimap->layout);
+
+	return (Vector2) {
+		.x = world.x + (window_position.x - bounds.x) / bounds.width * world.width,
+		.y = world.y + (window_position.y - bounds.y) / bounds.height * world.height
+	};
+}
@@ -0,0 +1,51 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "render.h"
+
+#ifndef MINIMAP_H_
+#define MINIMAP_H_
+
+// *
+// Minimap, one texture pixel per grid cell
+//
+// Pixels are rebuilt only for cells whose count or teams differ from the last state seen,
+// then each block of cells that changed is uploaded on its own (see 'CellTexture').
+// A state with a different grid layout (grid was retuned) starts the texture over.
+// Cost per frame follows cell count and changes, never unit count.
+// Drawn in window space on top of the scaled render target.
+// *
+typedef struct {
+	CellTexture texture;
+
+	// Cell values pixels were built from
+	int16_t *counts;
+	uint8_t *teams;
+
+	CellLayout layout;
+
+	// Window space area drawn to
+	Rectangle bounds;
+
+	// Tick of last state applied
+	uint32_t tick;
+
+	// Single allocation backing all arrays
+	void *memory;
+
+} Minimap;
+
+// Needs graphics context
+void MinimapInit(Minimap *minimap, CellLayout layout, Rectangle bounds);
+void MinimapClose(Minimap *minimap);
+
+// Apply cells that changed since last state, upload changed blocks
+void MinimapUpdate(Minimap *minimap, RenderState *state);
+
+// Map with camera view outline, call in window space
+void MinimapDraw(Minimap *minimap, Camera2D *camera);
+
+bool MinimapContains(Minimap *minimap, Vector2 window_position);
+Vector2 MinimapToWorld(Minimap *minimap, Vector2 window_position);
+
+#endif
@@ -0,0 +1,223 @@
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "particles.h"
+#include "render.h"
+#include "kmath.h"
+#include "memory.h"
+
+// Emitters slower than this don't emit
+#define EMITTER_MIN_SPEED 8.0f
+
+// Effect settings
+ParticleType particle_types[EFFECT_TYPE_COUNT] = {
+	[EFFECT_EXPLOSION] = {
+		.lifetime_min = 0.4f,
+		.lifetime_max = 1.2f,
+		.speed_min = 40.0f,
+		.speed_max = 260.0f,
+		.drag = 0.15f,
+		.size_start = 10.0f,
+		.size_end = 2.0f,
+		.color_start = (Color) { 255, 220, 120, 255 },
+		.color_end = (Color) { 200, 40, 20, 0 },
+		.burst = 48,
+		.texture = PARTICLE_TEX_SOFT
+	},
+	[EFFECT_SPARK] = {
+		.lifetime_min = 0.1f,
+		.lifetime_max = 0.3f,
+		.speed_min = 60.0f,
+		.speed_max = 200.0f,
+		.drag = 0.05f,
+		.size_start = 4.0f,
+		.size_end = 1.0f,
+		.color_start = (Color) { 255, 255, 200, 255 },
+		.color_end = (Color) { 255, 160, 40, 0 },
+		.burst = 6,
+		.texture = PARTICLE_TEX_SOFT
+	},
+	[EFFECT_THRUSTER] = {
+		.lifetime_min = 0.2f,
+		.lifetime_max = 0.4f,
+		.speed_min = 30.0f,
+		.speed_max = 60.0f,
+		.drag = 0.3f,
+		.size_start = 5.0f,
+		.size_end = 1.0f,
+		.color_start = (Color) { 120, 200, 255, 200 },
+		.color_end = (Color) { 40, 60, 255, 0 },
+		.burst = 1,
+		.texture = PARTICLE_TEX_SOFT
+	}
+};
+
+void ParticlesInit(Particles *p, uint32_t capacity) {
+	// One block, arrays laid out back to back
+	size_t floats = sizeof(float) * capacity;
+	uint8_t *memory = TrackedMalloc((floats * 7) + capacity);
+
+	*p = (Particles) {
+		.pos_x = (float*)(memory),
+		.pos_y = (float*)(memory + floats),
+		.vel_x = (float*)(memory + floats * 2),
+		.vel_y = (float*)(memory + floats * 3),
+		.drag = (float*)(memory + floats * 4),
+		.age = (float*)(memory + floats * 5),
+		.lifetime = (float*)(memory + floats * 6),
+		.type = (uint8_t*)(memory + floats * 7),
+		.head = 0,
+		.count = 0,
+		.capacity = capacity,
+		.effect_tick = 0,
+		.memory = memory
+	};
+
+	// Visual only, seed doesn't matter
+	RngSeed(&p->rng, 0x9E3779B97F4A7C15ull);
+}
+
+void ParticlesClose(Particles *p) {
+	for(uint8_t i = 0; i < PARTICLE_TEX_COUNT; i++) {
+		if(p->textures[i].id) UnloadTexture(p->textures[i]);
+	}
+
+	TrackedFree(p->memory);
+	*p = (Particles) { 0 };
+}
+
+void ParticlesResize(Particles *p, uint32_t capacity) {
+	if(capacity == p->capacity) return;
+
+	// Textures and effect progress carry over, short lived particles don't need to
+	Particles prev = *p;
+	TrackedFree(prev.memory);
+
+	ParticlesInit(p, capacity);
+
+	memcpy(p->textures, prev.textures, sizeof(p->textures));
+	p->effect_tick = prev.effect_tick;
+}
+
+void ParticlesLoadTextures(Particles *p) {
+	// Soft round dot, tinted per particle
+	Image soft = GenImageGradientRadial(32, 32, 0.0f, WHITE, BLANK);
+	p->textures[PARTICLE_TEX_SOFT] = LoadTextureFromImage(soft);
+	UnloadImage(soft);
+}
+
+void ParticlesSpawn(Particles *p, uint8_t type, Vector2 position, Vector2 direction, uint16_t count) {
+	if(!p->capacity) return;
+
+	ParticleType *pt = &particle_types[type];
+
+	for(uint16_t n = 0; n < count; n++) {
+		// Random direction if none given, otherwise spread around it
+		float angle = (Vector2LengthSqr(direction) > 0) 
+			? atan2f(direction.y, direction.x) + RngRange(&p->rng, -0.3f, 0.3f) 
+			: RngRange(&p->rng, 0, 2 * PI);
+
+		float speed = RngRange(&p->rng, pt->speed_min, pt->speed_max);
+
+		// Overwrite oldest once full
+		uint32_t i = p->head;
+		p->head = (p->head + 1) % p->capacity;
+		if(p->count < p->capacity) p->count++;
+
+		p->pos_x[i] = position.x;
+		p->pos_y[i] = position.y;
+		p->vel_x[i] = cosf(angle) * speed;
+		p->vel_y[i] = sinf(angle) * speed;
+		p->drag[i] = pt->drag;
+		p->age[i] = 0;
+		p->lifetime[i] = RngRange(&p->rng, pt->lifetime_min, pt->lifetime_max);
+		p->type[i] = type;
+	}
+}
+
+void ParticlesUpdate(Particles *p, RenderState *state, float dt) {
+	// Simulation went back in time (load, rewind), don't replay old effects
+	if(state->tick < p->effect_tick) p->effect_tick = state->tick;
+
+	// New one-off effects
+	for(uint32_t i = 0; i < state->effect_count; i++) {
+		RenderEffect *effect = &state->effects[i];
+		if(effect->tick < p->effect_tick) continue;
+
+		ParticlesSpawn(p, effect->type, effect->position, Vector2Zero(), particle_types[effect->type].burst);
+	}
+
+	// Everything before current tick was handled
+	p->effect_tick = state->tick;
+
+	// Continuous emitters, push particles out the back of moving entities
+	for(uint32_t i = 0; i < state->emitter_count; i++) {
+		RenderEmitter *emitter = &state->emitters[i];
+
+		float speed = Vector2Length(emitter->velocity);
+		if(speed < EMITTER_MIN_SPEED) continue;
+
+		// Fractional particles carried over by chance
+		uint16_t count = (uint16_t)(emitter->rate * dt + RngFloat(&p->rng));
+		if(!count) continue;
+
+		ParticlesSpawn(p, emitter->type, emitter->position, Vector2Scale(emitter->velocity, -1.0f / speed), count);
+	}
+
+	// Integrate, no branches, arrays never alias
+	float *restrict pos_x = p->pos_x;
+	float *restrict pos_y = p->pos_y;
+	float *restrict vel_x = p->vel_x;
+	float *restrict vel_y = p->vel_y;
+	float *restrict age = p->age;
+	const float *restrict drag = p->drag;
+
+	uint32_t count = p->count;
+
+	for(uint32_t i = 0; i < count; i++) {
+		// Linear approximation of 'powf(drag, dt)', close enough at frame rate
+		float keep = 1.0f - (1.0f - drag[i]) * dt;
+
+		vel_x[i] *= keep;
+		vel_y[i] *= keep;
+		pos_x[i] += vel_x[i] * dt;
+		pos_y[i] += vel_y[i] * dt;
+		age[i] += dt;
+	}
+}
+
+void ParticlesDraw(Particles *p) {
+	for(uint8_t tex = 0; tex < PARTICLE_TEX_COUNT; tex++) {
+		if(!p->textures[tex].id) continue;
+
+		// All particles using this texture go into one batch
+		rlSetTexture(p->textures[tex].id);
+		rlBegin(RL_QUADS);
+
+		for(uint32_t i = 0; i < p->count; i++) {
+			if(p->age[i] >= p->lifetime[i]) continue;
+
+			ParticleType *pt = &particle_types[p->type[i]];
+			if(pt->texture != tex) continue;
+
+			float t = p->age[i] / p->lifetime[i];
+			float half = Lerp(pt->size_start, pt->size_end, t) * 0.5f;
+
+			Color color = ColorLerp(pt->color_start, pt->color_end, t);
+			float x = p->pos_x[i];
+			float y = p->pos_y[i];
+
+			rlColor4ub(color.r, color.g, color.b, color.a);
+			rlTexCoord2f(0, 0); rlVertex2f(x - half, y - half);
+			rlTexCoord2f(0, 1); rlVertex2f(x - half, y + half);
+			rlTexCoord2f(1, 1); rlVertex2f(x + half, y + half);
+			rlTexCoord2f(1, 0); rlVertex2f(x + half, y - half);
+		}
+
+		rlEnd();
+		rlSetTexture(0);
+	}
+}
@@ -0,0 +1,90 @@
+#include <stdint.h>
+#include "raylib.h"
+#include "kmath.h"
+#include "render.h"
+
+#ifndef PARTICLES_H_
+#define PARTICLES_H_
+
+// Textures particles are drawn with, one batch each
+enum PARTICLE_TEXTURES {
+	PARTICLE_TEX_SOFT,
+	PARTICLE_TEX_COUNT
+};
+
+// Look of each effect type, indexed by 'EFFECT_TYPES'
+typedef struct {
+	float lifetime_min;
+	float lifetime_max;
+
+	float speed_min;
+	float speed_max;
+
+	// Velocity kept per second, 1 = no drag
+	float drag;
+
+	float size_start;
+	float size_end;
+
+	Color color_start;
+	Color color_end;
+
+	// Particles spawned per effect event, continuous emitters use their rate instead
+	uint16_t burst;
+
+	uint8_t texture;
+
+} ParticleType;
+
+// *
+// Visual only particles, owned by the render side and never part of the simulation
+//
+// Fixed capacity ring: spawning past capacity overwrites the oldest particle,
+// so the budget from config is a hard limit no matter how many explosions happen.
+// Fields are stored as separate arrays, update runs as straight loops over them.
+// *
+typedef struct {
+	float *pos_x;
+	float *pos_y;
+	float *vel_x;
+	float *vel_y;
+	float *drag;
+	float *age;
+	float *lifetime;
+
+	uint8_t *type;
+
+	uint32_t head;		// Next slot written
+	uint32_t count;		// Slots in use, stops growing at capacity
+	uint32_t capacity;
+
+	// Effects from ticks before this were already spawned
+	uint32_t effect_tick;
+
+	Texture2D textures[PARTICLE_TEX_COUNT];
+
+	Rng rng;
+
+	// Single allocation backing all arrays
+	void *memory;
+
+} Particles;
+
+void ParticlesInit(Particles *p, uint32_t capacity);
+void ParticlesClose(Particles *p);
+
+// Change budget, particles alive are dropped
+void ParticlesResize(Particles *p, uint32_t capacity);
+
+// Needs graphics context
+void ParticlesLoadTextures(Particles *p);
+
+void ParticlesSpawn(Particles *p, uint8_t type, Vector2 position, Vector2 direction, uint16_t count);
+
+// Spawn new effects and emitter output from render state, then age and move all particles
+void ParticlesUpdate(Particles *p, RenderState *state, float dt);
+
+// Draw all particles, one batch per texture
+void ParticlesDraw(Particles *p);
+
+#endif
@@ -0,0 +1,254 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "raylib.h"
+#include "prefabs.h"
+#include "handler.h"
+#include "render.h"
+#include "memory.h"
+
+#define streq(a, b) (strcmp((a), (b)) == 0)
+
+// Unit components shared by all ships
+#define PREFAB_SHIP (COMP_TRANSFORM | COMP_SPRITE | COMP_ORDERS | COMP_STEERING | COMP_EMITTER)
+
+Prefab prefabs[PREFAB_CAP] = {
+	[PREFAB_FIGHTER] = {
+		.name = "fighter",
+		.components = PREFAB_SHIP | COMP_SELECTABLE | COMP_HEALTH | COMP_VISION,
+		.transform = { .scale = { 1, 1 } },
+		.sprite = { .sprite_id = 1 },
+		.health = { .hp = 100, .max_hp = 100, .team = 0 },
+		.emitter = { .rate = 30, .type = EFFECT_THRUSTER },
+		.vision = { .radius = 400, .cell = -1 }
+	},
+	[PREFAB_DRONE] = {
+		.name = "drone",
+		.components = PREFAB_SHIP | COMP_HEALTH,
+		.transform = { .scale = { 1, 1 } },
+		.sprite = { .sprite_id = 2 },
+		.health = { .hp = 30, .max_hp = 30, .team = 1 },
+		.emitter = { .rate = 15, .type = EFFECT_THRUSTER }
+	},
+	[PREFAB_RAIDER] = {
+		.name = "raider",
+		.components = PREFAB_SHIP | COMP_HEALTH,
+		.transform = { .scale = { 1, 1 } },
+		.sprite = { .sprite_id = 2 },
+		.health = { .hp = 120, .max_hp = 120, .team = 1 },
+		.emitter = { .rate = 30, .type = EFFECT_THRUSTER }
+	},
+	[PREFAB_TURRET] = {
+		.name = "turret",
+		.components = COMP_TRANSFORM | COMP_SPRITE | COMP_TURRET | COMP_VISION,
+		.transform = { .scale = { 1, 1 } },
+		.sprite = { .sprite_id = 1 },
+		.turret = { .range = 250, .damage = 10, .cooldown = 0.5f, .target = -1, .policy = TARGET_FIRST, .team = 0 },
+		.vision = { .radius = 300, .cell = -1 }
+	},
+	[PREFAB_ASTEROID] = {
+		.name = "asteroid",
+		.components = COMP_TRANSFORM | COMP_SPRITE | COMP_OBSTACLE,
+		.transform = { .scale = { 1, 1 } },
+		.sprite = { .sprite_id = 0 },
+		.obstacle = { .radius = 40 }
+	}
+};
+
+uint16_t prefab_count = PREFAB_COUNT;
+
+// Names used in prefab files
+typedef struct {
+	char *name;
+	uint32_t value;
+
+} PrefabKeyword;
+
+static PrefabKeyword policy_keywords[] = {
+	{ "nearest", TARGET_NEAREST },
+	{ "first", TARGET_FIRST },
+	{ "strongest", TARGET_STRONGEST }
+};
+
+static PrefabKeyword effect_keywords[] = {
+	{ "explosion", EFFECT_EXPLOSION },
+	{ "spark", EFFECT_SPARK },
+	{ "thruster", EFFECT_THRUSTER }
+};
+
+#define keyword_find(_keywords, _word, _out) {									\
+	for(size_t _k = 0; _k < sizeof(_keywords) / sizeof(_keywords[0]); _k++) {	\
+		if(streq((_keywords)[_k].name, (_word))) *(_out) = (_keywords)[_k].value;	\
+	}																			\
+}
+
+int16_t PrefabFind(const char *name) {
+	for(int16_t i = 0; i < prefab_count; i++) {
+		if(strcmp(prefabs[i].name, name) == 0) return i;
+	}
+
+	return -1;
+}
+
+bool PrefabBuildable(const Prefab *prefab) {
+	if(!(prefab->components & COMP_TURRET) || (prefab->components & COMP_ORDERS)) return false;
+
+	return prefab->turret.team == VISION_TEAM;
+}
+
+// Parse one 'key: value' line of a prefab block
+static void PrefabParseLine(Prefab *prefab, char *key, char *val) {
+	if(streq(key, "components")) {
+		prefab->components = 0;
+
+		for(char *word = strtok(val, " "); word; word = strtok(NULL, " ")) {
+			uint32_t bit = 0;
+
+			for(uint32_t i = 0; i < COMP_REGISTERED_COUNT; i++) {
+				if(streq(component_types[i].name, word)) bit = (1u << i);
+			}
+
+			if(!bit) printf("ERROR: Unknown component in prefab %s: %s\n", prefab->name, word);
+			prefab->components |= bit;
+		}
+
+	} else if(streq(key, "sprite")) {
+		sscanf(val, "%hu", &prefab->sprite.sprite_id);
+
+	} else if(streq(key, "scale")) {
+		sscanf(val, "%f", &prefab->transform.scale.x);
+		prefab->transform.scale.y = prefab->transform.scale.x;
+
+	} else if(streq(key, "hp")) {
+		sscanf(val, "%f", &prefab->health.hp);
+		prefab->health.max_hp = prefab->health.hp;
+
+	} else if(streq(key, "team")) {
+		sscanf(val, "%hhu", &prefab->health.team);
+		prefab->turret.team = prefab->health.team;
+
+	} else if(streq(key, "radius")) {
+		sscanf(val, "%f", &prefab->obstacle.radius);
+
+	} else if(streq(key, "vision")) {
+		sscanf(val, "%f", &prefab->vision.radius);
+
+	} else if(streq(key, "range")) {
+		sscanf(val, "%f", &prefab->turret.range);
+
+	} else if(streq(key, "damage")) {
+		sscanf(val, "%f", &prefab->turret.damage);
+
+	} else if(streq(key, "cooldown")) {
+		sscanf(val, "%f", &prefab->turret.cooldown);
+
+	} else if(streq(key, "policy")) {
+		uint32_t policy = prefab->turret.policy;
+		keyword_find(policy_keywords, val, &policy);
+		prefab->turret.policy = policy;
+
+	} else if(streq(key, "emitter")) {
+		char type[32] = "";
+		sscanf(val, "%f %31s", &prefab->emitter.rate, type);
+
+		uint32_t effect = prefab->emitter.type;
+		keyword_find(effect_keywords, type, &effect);
+		prefab->emitter.type = effect;
+	}
+}
+
+bool PrefabsLoad(const char *path) {
+	FILE *pF = fopen(path, "r");
+
+	if(!pF) {
+		printf("ERROR: Could not open prefab file at: %s\n", path);
+		return false;
+	}
+
+	Prefab *prefab = NULL;
+
+	char line[128];
+	while(fgets(line, sizeof(line), pF)) {
+		char *n = strchr(line, '\n');
+		if(n) *n = '\0';
+
+		// New prefab, '[name]'
+		if(line[0] == '[') {
+			char *end = strchr(line, ']');
+			if(end) *end = '\0';
+
+			char *name = line + 1;
+			int16_t i = PrefabFind(name);
+
+			if(i < 0) {
+				if(prefab_count >= PREFAB_CAP) {
+					printf("ERROR: Too many prefabs, skipping %s\n", name);
+					prefab = NULL;
+					continue;
+				}
+
+				i = prefab_count++;
+			}
+
+			// Fresh defaults, file describes the whole prefab
+			prefab = &prefabs[i];
+			*prefab = (Prefab) {
+				.transform = { .scale = { 1, 1 } },
+				.turret = { .target = -1 },
+				.vision = { .cell = -1 }
+			};
+
+			snprintf(prefab->name, PREFAB_NAME_LEN, "%.*s", PREFAB_NAME_LEN - 1, name);
+			continue;
+		}
+
+		// Split key and value
+		char *sep = strstr(line, ": ");
+		if(!sep || !prefab) continue;
+
+		*sep = '\0';
+		PrefabParseLine(prefab, line, sep + 2);
+	}
+
+	fclose(pF);
+	printf("prefabs: %d\n", prefab_count);
+
+	return true;
+}
+
+#define prefab_default(_id, _field, _pool, _type) [CI_##_id] = &prefab->_field,
+
+INT_N SpawnBatch(Handler *handler, Prefab *prefab, INT_N count, const Vector2 *positions, INT_N *ids) {
+	ArenaMark mark = ArenaGetMark(handler->arena);
+	if(!ids) ids = ArenaAlloc(handler->arena, sizeof(INT_N) * count);
+
+	// Defaults by component index
+	const void *defaults[COMP_TYPE_COUNT] = {
+		COMPONENT_LIST(prefab_default)
+	};
+
+	count = AddEntityBatch(handler, prefab->components, defaults, count, ids);
+
+	// Place entities, previous position matches so they don't interpolate in from elsewhere
+	if(prefab->components & COMP_TRANSFORM) {
+		for(INT_N k = 0; k < count; k++) {
+			comp_Transform *transform = HandlerGetComponent(handler, ids[k], COMP_TRANSFORM);
+
+			transform->position = positions[k];
+			transform->prev_position = positions[k];
+
+			GridInsert(&handler->grid, ids[k], positions[k]);
+		}
+	}
+
+	ArenaRewind(handler->arena, mark);
+
+	return count;
+}
+
+INT_N SpawnPrefab(Handler *handler, Prefab *prefab, Vector2 position) {
+	INT_N id = -1;
+	SpawnBatch(handler, prefab, 1, &position, &id);
+
+	return id;
+}
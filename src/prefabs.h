@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "handler.h"
+
+#ifndef PREFABS_H_
+#define PREFABS_H_
+
+#define PREFAB_NAME_LEN 32
+
+#define prefab_field(_id, _field, _pool, _type) _type _field;
+
+// Built-in prefabs plus ones added from file
+#define PREFAB_CAP 64
+
+// Entity template: which components to create and what to fill them with
+// Only components set in 'components' are used
+typedef struct {
+	char name[PREFAB_NAME_LEN];
+	uint32_t components;
+
+	// One field per registered component, eg. 'comp_Transform transform'
+	COMPONENT_LIST(prefab_field)
+
+} Prefab;
+
+// Built-in prefabs, always present, can be overridden from file
+enum PREFAB_IDS {
+	PREFAB_FIGHTER,
+	PREFAB_DRONE,
+	PREFAB_RAIDER,
+	PREFAB_TURRET,
+	PREFAB_ASTEROID,
+	PREFAB_COUNT
+};
+
+extern Prefab prefabs[PREFAB_CAP];
+extern uint16_t prefab_count;
+
+// Index of prefab with name, -1 if there's none
+int16_t PrefabFind(const char *name);
+
+// Player can place it, a stationary turret on the player's team
+bool PrefabBuildable(const Prefab *prefab);
+
+// *
+// Read prefabs from file, a '[name]' line followed by 'key: value' lines
+//
+// eg.
+// [interceptor]
+// components: transform sprite orders steering emitter health
+// sprite: 2
+// hp: 60
+// team: 1
+// emitter: 20 thruster
+//
+// Prefabs with a known name are replaced, others are added
+// *
+bool PrefabsLoad(const char *path);
+
+// Create 'count' entities from prefab, one per position, ids written to 'ids' if not NULL
+// Returns number created, less than 'count' if pools are full
+INT_N SpawnBatch(Handler *handler, Prefab *prefab, INT_N count, const Vector2 *positions, INT_N *ids);
+
+// Create entity from prefab at position, -1 if pools are full
+INT_N SpawnPrefab(Handler *handler, Prefab *prefab, Vector2 position);
+
+#endif
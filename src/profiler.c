@@ -0,0 +1,103 @@
+#include <stdint.h>
+#include <stdio.h>
+#include "raylib.h"
+#include "profiler.h"
+#include "memory.h"
+
+// Weight of the newest sample in smoothed timings
+#define PROF_SMOOTHING 0.05f
+
+// *
+// Zones and values are written by the thread that runs them, the simulation may run on its own,
+// and read on the main thread by the overlay and dynamic resolution.
+// Timings and values go through relaxed atomics, 'start' is only touched by the writing thread.
+// *
+#define prof_store(_field, _val) { float _v = (_val); __atomic_store(&(_field), &_v, __ATOMIC_RELAXED); }
+
+static float prof_load(float *field) {
+	float v;
+	__atomic_load(field, &v, __ATOMIC_RELAXED);
+	return v;
+}
+
+ProfileZone prof_zones[PROF_ZONE_COUNT] = { 0 };
+
+char *prof_zone_names[PROF_ZONE_COUNT] = {
+	"update",
+	"sim",
+	"particles",
+	"ui",
+	"draw buffer",
+	"draw window"
+};
+
+float prof_values[PROF_VALUE_COUNT] = { 0 };
+
+char *prof_value_names[PROF_VALUE_COUNT] = {
+	"grid cell size",
+	"grid cols",
+	"grid rows",
+	"grid occupied cells",
+	"grid fullest cell",
+	"grid query cost",
+	"grid retunes"
+};
+
+// Arena shown in overlay
+Arena *prof_arena = NULL;
+
+void ProfilerBeginFrame() {
+	MemStatsBeginFrame();
+}
+
+void ProfileBegin(uint8_t zone) {
+	prof_zones[zone].start = GetTime();
+}
+
+void ProfileEnd(uint8_t zone) {
+	ProfileZone *pz = &prof_zones[zone];
+
+	float ms = (GetTime() - pz->start) * 1000.0;
+	float avg_ms = prof_load(&pz->avg_ms);
+
+	prof_store(pz->ms, ms);
+	prof_store(pz->avg_ms, avg_ms + (ms - avg_ms) * PROF_SMOOTHING);
+}
+
+float ProfileZoneMs(uint8_t zone) {
+	return prof_load(&prof_zones[zone].ms);
+}
+
+void ProfileValue(uint8_t value, float v) {
+	prof_store(prof_values[value], v);
+}
+
+void ProfilerWatchArena(Arena *arena) {
+	prof_arena = arena;
+}
+
+void ProfilerDraw(int x, int y) {
+	const int font_size = 20;
+
+	for(uint8_t i = 0; i < PROF_ZONE_COUNT; i++) {
+		DrawText(TextFormat("%s: %.2f ms", prof_zone_names[i], prof_load(&prof_zones[i].avg_ms)), x, y, font_size, LIME);
+		y += font_size;
+	}
+
+	DrawText(TextFormat("heap allocs/frame: %d", mem_stats.last_frame_heap_allocs), x, y, font_size, LIME);
+	y += font_size;
+
+	DrawText(TextFormat("heap allocs total: %d (%d freed)", mem_stats.heap_allocs, mem_stats.heap_frees), x, y, font_size, LIME);
+	y += font_size;
+
+	if(prof_arena) {
+		DrawText(TextFormat("frame arena: %zu / %zu KiB (peak %zu)",
+			ArenaUsed(prof_arena) / 1024, prof_arena->capacity / 1024, prof_arena->peak / 1024), x, y, font_size, LIME);
+		y += font_size;
+	}
+
+	for(uint8_t i = 0; i < PROF_VALUE_COUNT; i++) {
+		DrawText(TextFormat("%s: %.4g", prof_value_names[i], prof_load(&prof_values[i])), x, y, font_size, LIME);
+		y += font_size;
+	}
+}
@@ -0,0 +1,57 @@
+#include <stdint.h>
+#include "memory.h"
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+// Timed sections of a frame, used as index into zone arrays
+enum PROFILE_ZONES {
+	PROF_UPDATE,
+	PROF_SIM,
+	PROF_PARTICLES,
+	PROF_UI,
+	PROF_DRAW_BUFFER,
+	PROF_DRAW_WINDOW,
+	PROF_ZONE_COUNT
+};
+
+// Values reported by systems, shown below zone timings
+enum PROFILE_VALUES {
+	PROF_GRID_CELL_SIZE,
+	PROF_GRID_COLS,
+	PROF_GRID_ROWS,
+	PROF_GRID_OCCUPIED,		// Cells holding entities at last tuning sample
+	PROF_GRID_PEAK,			// Entries in fullest cell
+	PROF_GRID_QUERY_COST,	// Predicted cost per query at current cell size
+	PROF_GRID_RETUNES,
+	PROF_VALUE_COUNT
+};
+
+typedef struct {
+	double start;
+
+	float ms;		// Time spent last frame
+	float avg_ms;	// Smoothed time
+
+} ProfileZone;
+
+// Reset per-frame counters, call once at the very start of a frame
+void ProfilerBeginFrame();
+
+// Each zone is timed by one thread at a time, others may read it
+void ProfileBegin(uint8_t zone);
+void ProfileEnd(uint8_t zone);
+
+// Last timing of zone, safe from any thread
+float ProfileZoneMs(uint8_t zone);
+
+// Latest value, may be set from the simulation thread
+void ProfileValue(uint8_t value, float v);
+
+// Set arena displayed in the overlay
+void ProfilerWatchArena(Arena *arena);
+
+// Draw zone timings and allocation counters
+void ProfilerDraw(int x, int y);
+
+#endif
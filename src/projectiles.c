@@ -0,0 +1,108 @@
+#include <stdint.h>
+#include <string.h>
+#include "raylib.h"
+#include "projectiles.h"
+#include "memory.h"
+
+void ProjectilesInit(Projectiles *p, uint32_t capacity) {
+	// One block, arrays laid out back to back, largest fields first
+	size_t floats = sizeof(float) * capacity;
+	uint8_t *memory = TrackedMalloc(PROJECTILE_SIZE * capacity);
+
+	*p = (Projectiles) {
+		.pos_x = (float*)(memory),
+		.pos_y = (float*)(memory + floats),
+		.vel_x = (float*)(memory + floats * 2),
+		.vel_y = (float*)(memory + floats * 3),
+		.lifetime = (float*)(memory + floats * 4),
+		.damage = (float*)(memory + floats * 5),
+		.owner = (int16_t*)(memory + floats * 6),
+		.team = (uint8_t*)(memory + floats * 6 + sizeof(int16_t) * capacity),
+		.count = 0,
+		.capacity = capacity,
+		.memory = memory
+	};
+}
+
+void ProjectilesClose(Projectiles *p) {
+	TrackedFree(p->memory);
+	*p = (Projectiles) { 0 };
+}
+
+bool ProjectileSpawn(Projectiles *p, Vector2 position, Vector2 velocity, float lifetime, float damage, int16_t owner, uint8_t team) {
+	if(p->count >= p->capacity) return false;
+
+	uint32_t i = p->count++;
+
+	p->pos_x[i] = position.x;
+	p->pos_y[i] = position.y;
+	p->vel_x[i] = velocity.x;
+	p->vel_y[i] = velocity.y;
+	p->lifetime[i] = lifetime;
+	p->damage[i] = damage;
+	p->owner[i] = owner;
+	p->team[i] = team;
+
+	return true;
+}
+
+void ProjectileDespawn(Projectiles *p, uint32_t i) {
+	uint32_t last = --p->count;
+	if(i == last) return;
+
+	p->pos_x[i] = p->pos_x[last];
+	p->pos_y[i] = p->pos_y[last];
+	p->vel_x[i] = p->vel_x[last];
+	p->vel_y[i] = p->vel_y[last];
+	p->lifetime[i] = p->lifetime[last];
+	p->damage[i] = p->damage[last];
+	p->owner[i] = p->owner[last];
+	p->team[i] = p->team[last];
+}
+
+void ProjectilesIntegrate(Projectiles *p, float dt) {
+	// Arrays never alias, lets the compiler vectorize these loops
+	float *restrict pos_x = p->pos_x;
+	float *restrict pos_y = p->pos_y;
+	const float *restrict vel_x = p->vel_x;
+	const float *restrict vel_y = p->vel_y;
+	float *restrict lifetime = p->lifetime;
+
+	uint32_t count = p->count;
+
+	for(uint32_t i = 0; i < count; i++) {
+		pos_x[i] += vel_x[i] * dt;
+		pos_y[i] += vel_y[i] * dt;
+		lifetime[i] -= dt;
+	}
+}
+
+// Copy each array's live range to or from blob, arrays are stored one after another
+static void ProjectilesCopy(Projectiles *p, uint8_t *blob, uint32_t count, bool to_blob) {
+	void *arrays[] = { p->pos_x, p->pos_y, p->vel_x, p->vel_y, p->lifetime, p->damage, p->owner, p->team };
+	size_t sizes[] = { 
+		sizeof(float), sizeof(float), sizeof(float), sizeof(float), 
+		sizeof(float), sizeof(float), sizeof(int16_t), sizeof(uint8_t) 
+	};
+
+	for(uint8_t k = 0; k < 8; k++) {
+		if(to_blob) memcpy(blob, arrays[k], sizes[k] * count);
+		else memcpy(arrays[k], blob, sizes[k] * count);
+
+		blob += sizes[k] * count;
+	}
+}
+
+size_t ProjectilesWrite(Projectiles *p, uint8_t *dst) {
+	ProjectilesCopy(p, dst, p->count, true);
+	return PROJECTILE_SIZE * p->count;
+}
+
+size_t ProjectilesRead(Projectiles *p, const uint8_t *src, uint32_t count) {
+	if(count > p->capacity) return 0;
+
+	p->count = count;
+	ProjectilesCopy(p, (uint8_t*)src, count, false);
+
+	return PROJECTILE_SIZE * count;
+}
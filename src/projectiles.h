@@ -0,0 +1,62 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+
+#ifndef PROJECTILES_H_
+#define PROJECTILES_H_
+
+// Most projectiles alive at once
+#define PROJECTILE_CAP		65536
+
+// Collision radius
+#define PROJECTILE_RADIUS	2.0f
+
+// Bytes stored per projectile in snapshots
+#define PROJECTILE_SIZE		(sizeof(float) * 6 + sizeof(int16_t) + sizeof(uint8_t))
+
+// *
+// Projectile pool, kept apart from entities:
+// projectiles spawn and die every few ticks and only need a handful of fields,
+// going through 'AddEntity()' would cost a component mapping and several pool slots each.
+//
+// Fields are stored as separate arrays (struct of arrays) so update loops
+// stream through memory and can be vectorized by the compiler.
+// Live projectiles are always packed in [0, count), removal swaps the last one in.
+// *
+typedef struct {
+	float *pos_x;
+	float *pos_y;
+	float *vel_x;
+	float *vel_y;
+	float *lifetime;	// Seconds left
+	float *damage;
+
+	int16_t *owner;		// Entity id that fired it
+	uint8_t *team;		// Won't hit entities of this team
+
+	uint32_t count;
+	uint32_t capacity;
+
+	// Single allocation backing all arrays
+	void *memory;
+
+} Projectiles;
+
+void ProjectilesInit(Projectiles *p, uint32_t capacity);
+void ProjectilesClose(Projectiles *p);
+
+// Returns false if pool is full
+bool ProjectileSpawn(Projectiles *p, Vector2 position, Vector2 velocity, float lifetime, float damage, int16_t owner, uint8_t team);
+
+// Remove by index, O(1), moves last projectile into 'i'
+void ProjectileDespawn(Projectiles *p, uint32_t i);
+
+// Move all projectiles and age them, doesn't remove expired ones
+void ProjectilesIntegrate(Projectiles *p, float dt);
+
+// Serialize live projectiles, 'count * PROJECTILE_SIZE' bytes, returns bytes written/read
+size_t ProjectilesWrite(Projectiles *p, uint8_t *dst);
+size_t ProjectilesRead(Projectiles *p, const uint8_t *src, uint32_t count);
+
+#endif
@@ -0,0 +1,290 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "render.h"
+#include "game.h"
+#include "memory.h"
+
+void RenderStateInit(RenderState *state, uint32_t item_capacity, uint32_t line_capacity, uint32_t projectile_capacity) {
+	*state = (RenderState) {
+		.items = TrackedCalloc(item_capacity, sizeof(RenderItem)),
+		.lines = TrackedCalloc(line_capacity, sizeof(RenderLine)),
+		.projectiles = TrackedCalloc(projectile_capacity, sizeof(RenderProjectile)),
+		.effects = TrackedCalloc(RENDER_EFFECT_CAP, sizeof(RenderEffect)),
+		.emitters = TrackedCalloc(item_capacity, sizeof(RenderEmitter)),
+		.cell_counts = TrackedCalloc(CELLS_MAX, sizeof(int16_t)),
+		.cell_teams = TrackedCalloc(CELLS_MAX, sizeof(uint8_t)),
+		.cell_vision = TrackedCalloc(CELLS_MAX, sizeof(uint8_t)),
+		.item_capacity = item_capacity,
+		.line_capacity = line_capacity,
+		.projectile_capacity = projectile_capacity,
+		.emitter_capacity = item_capacity
+	};
+}
+
+void RenderStateClose(RenderState *state) {
+	TrackedFree(state->items);
+	TrackedFree(state->lines);
+	TrackedFree(state->projectiles);
+	TrackedFree(state->effects);
+	TrackedFree(state->emitters);
+	TrackedFree(state->cell_counts);
+	TrackedFree(state->cell_teams);
+	TrackedFree(state->cell_vision);
+
+	*state = (RenderState) { 0 };
+}
+
+void RenderBufferInit(RenderBuffer *buf, uint32_t item_capacity, uint32_t line_capacity, uint32_t projectile_capacity) {
+	for(uint8_t i = 0; i < 3; i++) 
+		RenderStateInit(&buf->states[i], item_capacity, line_capacity, projectile_capacity);
+
+	buf->front = 0;
+	buf->latest = 1;
+	buf->back = 2;
+}
+
+void RenderBufferClose(RenderBuffer *buf) {
+	for(uint8_t i = 0; i < 3; i++) 
+		RenderStateClose(&buf->states[i]);
+}
+
+RenderState *RenderBufferBack(RenderBuffer *buf) {
+	return &buf->states[buf->back];
+}
+
+void RenderBufferPublish(RenderBuffer *buf) {
+	// Hand back buffer over, take whichever one was waiting
+	int prev = __atomic_exchange_n(&buf->latest, buf->back | RENDER_BUFFER_FRESH, __ATOMIC_ACQ_REL);
+	buf->back = prev & ~RENDER_BUFFER_FRESH;
+}
+
+RenderState *RenderBufferAcquire(RenderBuffer *buf) {
+	// Only swap if something new was published
+	if(__atomic_load_n(&buf->latest, __ATOMIC_ACQUIRE) & RENDER_BUFFER_FRESH) {
+		int prev = __atomic_exchange_n(&buf->latest, buf->front, __ATOMIC_ACQ_REL);
+		buf->front = prev & ~RENDER_BUFFER_FRESH;
+	}
+
+	return &buf->states[buf->front];
+}
+
+uint8_t RenderLodTier(RenderLod *lod, float zoom) {
+	if(zoom < lod->far_zoom) return LOD_FAR;
+	if(zoom < lod->mid_zoom) return LOD_MID;
+
+	return LOD_NEAR;
+}
+
+// World space rectangle seen through camera
+static Rectangle RenderViewRec(Camera2D *camera) {
+	Vector2 start = GetScreenToWorld2D(Vector2Zero(), *camera);
+	Vector2 end = GetScreenToWorld2D((Vector2){ VIRTUAL_WIDTH, VIRTUAL_HEIGHT }, *camera);
+
+	return (Rectangle) { start.x, start.y, end.x - start.x, end.y - start.y };
+}
+
+// One blob per occupied cell in view, cost follows visible cells instead of unit count
+static void RenderCellAggregates(RenderState *state, Rectangle view) {
+	CellLayout *layout = &state->layout;
+	if(!layout->cols || !layout->rows) return;
+
+	int16_t col_start, row_start, col_end, row_end;
+	CellRange(layout, view, &col_start, &row_start, &col_end, &row_end);
+
+	float max_radius = fminf(layout->cell_size.x, layout->cell_size.y) * 0.5f;
+
+	for(int16_t r = row_start; r <= row_end; r++) {
+		for(int16_t c = col_start; c <= col_end; c++) {
+			// Cells holding only enemies in fog have no teams set
+			int16_t count = state->cell_counts[c + r * layout->cols];
+			if(count <= 0 || !state->cell_teams[c + r * layout->cols]) continue;
+
+			Vector2 center = Vector2Add(CellCorner(layout, c, r), Vector2Scale(layout->cell_size, 0.5f));
+
+			// Area grows with unit count
+			float radius = fminf(max_radius * 0.25f * sqrtf(count), max_radius);
+
+			DrawCircleV(center, radius, ColorAlpha(RAYWHITE, 0.5f));
+		}
+	}
+}
+
+void RenderStateDraw(RenderState *state, Camera2D *camera, RenderLod *lod) {
+	// How far we are into the next tick
+	float alpha = (GetTime() - state->time) * state->tick_rate;
+	alpha = Clamp(alpha, 0, 1);
+
+	uint8_t tier = RenderLodTier(lod, camera->zoom);
+	Rectangle view = RenderViewRec(camera);
+
+	// Aggregates replace the per-cell debug view when zoomed out
+	if(tier == LOD_FAR) {
+		RenderCellAggregates(state, view);
+		return;
+	}
+
+	RenderGridDebugView(state, camera);
+
+	// Widened so units on the view edge still draw
+	Rectangle cull = (Rectangle) { view.x - 16, view.y - 16, view.width + 32, view.height + 32 };
+
+	if(tier == LOD_MID) {
+		for(uint32_t i = 0; i < state->item_count; i++) {
+			RenderItem *item = &state->items[i];
+			if(!CheckCollisionPointRec(item->position, cull)) continue;
+
+			Color color = (item->flags & RENDER_SELECTED) ? SKYBLUE : RAYWHITE;
+			DrawRectangleV(Vector2SubtractValue(item->position, 4), (Vector2){ 8, 8 }, color);
+		}
+
+		return;
+	}
+
+	for(uint32_t i = 0; i < state->line_count; i++) {
+		RenderLine *line = &state->lines[i];
+		DrawLineV(line->from, line->to, ColorAlpha(SKYBLUE, 0.5f));
+	}
+
+	for(uint32_t i = 0; i < state->item_count; i++) {
+		RenderItem *item = &state->items[i];
+		if(!CheckCollisionPointRec(item->position, cull)) continue;
+
+		// Interpolate between last two ticks
+		Vector2 position = Vector2Lerp(item->prev_position, item->position, alpha);
+
+		DrawCircleV(position, 10, ColorAlpha(RAYWHITE, 0.5f));
+		DrawCircleLinesV(position, 10, (item->flags & RENDER_SELECTED) ? SKYBLUE : RAYWHITE);
+	}
+
+	// Projectiles are drawn as short streaks, state holds positions at end of tick
+	float back = (1.0f - alpha) / state->tick_rate;
+
+	for(uint32_t i = 0; i < state->projectile_count; i++) {
+		RenderProjectile *projectile = &state->projectiles[i];
+
+		Vector2 head = Vector2Subtract(projectile->position, Vector2Scale(projectile->velocity, back));
+		Vector2 tail = Vector2Subtract(head, Vector2Scale(projectile->velocity, 0.02f));
+
+		DrawLineV(tail, head, YELLOW);
+	}
+}
+
+void RenderGridDebugView(RenderState *state, Camera2D *camera) {
+	CellLayout *layout = &state->layout;
+	if(!layout->cols || !layout->rows) return;
+
+	int16_t col_start, row_start, col_end, row_end;
+	CellRange(layout, RenderViewRec(camera), &col_start, &row_start, &col_end, &row_end);
+
+	for(int16_t r = row_start; r <= row_end; r++) {
+		for(int16_t c = col_start; c <= col_end; c++) {
+			Vector2 pos = CellCorner(layout, c, r);
+
+			int16_t count = state->cell_counts[c + r * layout->cols];
+			Color color = (count > 0) ? RAYWHITE : DARKGRAY;
+
+			Rectangle rec = (Rectangle) {
+				.x = pos.x,
+				.y = pos.y,
+				.width = layout->cell_size.x,
+				.height = layout->cell_size.y
+			};
+
+			DrawRectangleLinesEx(rec, 1.5f, color);
+			DrawText(TextFormat("Count: %d", count), pos.x + 4, pos.y + 4, 10, color);
+		}
+	}
+}
+
+void RenderStaticsDraw(RenderStaticLayer *statics, Rectangle region) {
+	if(!statics->count) return;
+
+	// Cells in region, widened so objects poking in from outside still draw
+	float reach = statics->max_radius;
+	Rectangle wide = (Rectangle) { region.x - reach, region.y - reach, region.width + reach * 2, region.height + reach * 2 };
+
+	int16_t col_start, row_start, col_end, row_end;
+	CellRange(&statics->layout, wide, &col_start, &row_start, &col_end, &row_end);
+
+	uint16_t cols = statics->layout.cols;
+
+	for(int16_t r = row_start; r <= row_end; r++) {
+		// Cells in a row are contiguous, draw the whole span at once
+		uint32_t first = statics->cell_start[col_start + r * cols];
+		uint32_t last = statics->cell_start[col_end + 1 + r * cols];
+
+		for(uint32_t i = first; i < last; i++) {
+			const RenderStatic *item = &statics->items[i];
+
+			DrawCircleV(item->position, item->radius, ColorAlpha(GRAY, 0.5f));
+			DrawCircleLinesV(item->position, item->radius, LIGHTGRAY);
+		}
+	}
+}
+
+void CellTextureInit(CellTexture *ct, uint16_t cols, uint16_t rows) {
+	uint32_t cell_count = cols * rows;
+	uint16_t block_cols = (cols + CELL_TEXTURE_BLOCK - 1) / CELL_TEXTURE_BLOCK;
+	uint16_t block_rows = (rows + CELL_TEXTURE_BLOCK - 1) / CELL_TEXTURE_BLOCK;
+
+	uint8_t *memory = TrackedCalloc(1, sizeof(Color) * cell_count + block_cols * block_rows);
+
+	*ct = (CellTexture) {
+		.pixels = (Color*)memory,
+		.dirty_blocks = memory + sizeof(Color) * cell_count,
+		.block_cols = block_cols,
+		.block_rows = block_rows,
+		.cols = cols,
+		.rows = rows,
+		.memory = memory
+	};
+
+	Image image = (Image) {
+		.data = ct->pixels,
+		.width = cols,
+		.height = rows,
+		.mipmaps = 1,
+		.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+	};
+
+	ct->texture = LoadTextureFromImage(image);
+}
+
+void CellTextureClose(CellTexture *ct) {
+	if(ct->texture.id) UnloadTexture(ct->texture);
+	TrackedFree(ct->memory);
+
+	*ct = (CellTexture) { 0 };
+}
+
+void CellTextureSet(CellTexture *ct, uint16_t c, uint16_t r, Color color) {
+	ct->pixels[c + r * ct->cols] = color;
+	ct->dirty_blocks[(c / CELL_TEXTURE_BLOCK) + (r / CELL_TEXTURE_BLOCK) * ct->block_cols] = 1;
+}
+
+void CellTextureUpload(CellTexture *ct) {
+	// Rows of a block packed together first, upload takes contiguous pixels
+	Color block[CELL_TEXTURE_BLOCK * CELL_TEXTURE_BLOCK];
+
+	for(uint16_t br = 0; br < ct->block_rows; br++) {
+		for(uint16_t bc = 0; bc < ct->block_cols; bc++) {
+			uint8_t *dirty = &ct->dirty_blocks[bc + br * ct->block_cols];
+			if(!*dirty) continue;
+
+			*dirty = 0;
+
+			uint16_t x = bc * CELL_TEXTURE_BLOCK;
+			uint16_t y = br * CELL_TEXTURE_BLOCK;
+			uint16_t w = (x + CELL_TEXTURE_BLOCK <= ct->cols) ? CELL_TEXTURE_BLOCK : ct->cols - x;
+			uint16_t h = (y + CELL_TEXTURE_BLOCK <= ct->rows) ? CELL_TEXTURE_BLOCK : ct->rows - y;
+
+			for(uint16_t r = 0; r < h; r++)
+				memcpy(&block[r * w], &ct->pixels[x + (y + r) * ct->cols], sizeof(Color) * w);
+
+			UpdateTextureRec(ct->texture, (Rectangle){ x, y, w, h }, block);
+		}
+	}
+}
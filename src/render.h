@@ -0,0 +1,236 @@
+#include <stdint.h>
+#include "raylib.h"
+#include "cells.h"
+
+#ifndef RENDER_H_
+#define RENDER_H_
+
+// Render item flags
+#define RENDER_SELECTED		0x01
+
+// Cell team bits, '1 << team' for teams below 7, entities without a team use the top bit
+#define RENDER_TEAM_NEUTRAL	0x80
+
+// Everything needed to draw one entity
+typedef struct {
+	Vector2 prev_position;
+	Vector2 position;
+
+	uint16_t sprite_id;
+	uint16_t frame;
+
+	uint8_t flags;
+
+} RenderItem;
+
+// Order waypoint line
+typedef struct {
+	Vector2 from;
+	Vector2 to;
+
+} RenderLine;
+
+// One-off visual effects, spawned by the simulation, turned into particles by the renderer
+enum EFFECT_TYPES {
+	EFFECT_EXPLOSION,
+	EFFECT_SPARK,
+	EFFECT_THRUSTER,	// Continuous, from emitter components
+	EFFECT_TYPE_COUNT
+};
+
+// Effects stay in render states for this many ticks,
+// so they aren't lost when the renderer skips a state
+#define RENDER_EFFECT_TICKS	8
+#define RENDER_EFFECT_CAP	256
+
+typedef struct {
+	Vector2 position;
+	uint32_t tick;		// Tick the effect happened on
+
+	uint8_t type;
+
+} RenderEffect;
+
+// Continuous particle source
+typedef struct {
+	Vector2 position;
+	Vector2 velocity;
+
+	float rate;			// Particles per second
+	uint8_t type;
+
+} RenderEmitter;
+
+// Projectile, position is extrapolated back for interpolation
+typedef struct {
+	Vector2 position;
+	Vector2 velocity;
+
+} RenderProjectile;
+
+// Scenery object, never moves
+typedef struct {
+	Vector2 position;
+	float radius;
+	float rotation;
+
+	uint16_t sprite_id;
+
+} RenderStatic;
+
+// Read-only view of the static layer, sorted by cell like the simulation side
+// Objects in cell c are items[cell_start[c] .. cell_start[c + 1]]
+typedef struct {
+	const RenderStatic *items;
+	const uint32_t *cell_start;
+
+	CellLayout layout;
+
+	float max_radius;
+	uint32_t count;
+
+} RenderStaticLayer;
+
+// Immutable copy of what the simulation looks like after a tick
+// Written by the simulation, read by the renderer, never both at once
+typedef struct {
+	RenderItem *items;
+	RenderLine *lines;
+	RenderProjectile *projectiles;
+	RenderEffect *effects;
+	RenderEmitter *emitters;
+
+	// Static scenery, points into level data, not copied per tick
+	RenderStaticLayer statics;
+
+	// Grid cell entity counts, for debug view and minimap
+	int16_t *cell_counts;
+
+	// Teams present per cell, 'RENDER_TEAM_NEUTRAL' bits, enemies in fog are left out
+	uint8_t *cell_teams;
+
+	// Grid the cell arrays above follow, changes when the grid is retuned
+	CellLayout layout;
+
+	// Fog of war per cell, 'VISION_STATES'
+	uint8_t *cell_vision;
+	CellLayout vision_layout;
+
+	uint32_t item_count;
+	uint32_t item_capacity;
+
+	uint32_t line_count;
+	uint32_t line_capacity;
+
+	uint32_t projectile_count;
+	uint32_t projectile_capacity;
+
+	uint32_t effect_count;
+
+	uint32_t emitter_count;
+	uint32_t emitter_capacity;	// Same as 'item_capacity'
+
+	// HUD counters, units of the player's team and enemies in sight
+	uint32_t unit_count;
+	uint32_t enemy_count;
+	uint32_t selected_count;
+
+	// Wave progress, 'wave' equals 'wave_count' once all waves are out
+	uint16_t wave;
+	uint16_t wave_count;
+	float wave_timer;
+
+	// Time ('GetTime()') the state became current, used for interpolation
+	double time;
+
+	uint32_t tick;
+	uint16_t tick_rate;
+
+} RenderState;
+
+// Detail units are drawn with, picked from camera zoom
+enum RENDER_LOD_TIERS {
+	LOD_NEAR,	// Full detail, interpolated units, waypoints and projectiles
+	LOD_MID,	// Simplified markers, no interpolation or animation
+	LOD_FAR,	// Units aggregated per grid cell into density blobs
+};
+
+// Zoom thresholds between tiers, zoom below 'mid_zoom' is mid tier, below 'far_zoom' far
+typedef struct {
+	float mid_zoom;
+	float far_zoom;
+
+} RenderLod;
+
+// Texture with one pixel per grid cell
+// Pixels are set on the CPU copy, blocks holding changed pixels are uploaded on their own
+#define CELL_TEXTURE_BLOCK	16
+
+typedef struct {
+	Texture2D texture;
+
+	Color *pixels;
+
+	// One flag per block, set when a pixel inside changed
+	uint8_t *dirty_blocks;
+	uint16_t block_cols;
+	uint16_t block_rows;
+
+	uint16_t cols;
+	uint16_t rows;
+
+	// Single allocation backing all arrays
+	void *memory;
+
+} CellTexture;
+
+// Triple buffer of render states
+// Writer fills 'back' then publishes it, reader picks up the newest published state,
+// neither side ever waits for the other
+#define RENDER_BUFFER_FRESH 0x04
+
+typedef struct {
+	RenderState states[3];
+
+	// Index of newest published state, 'RENDER_BUFFER_FRESH' set if reader hasn't taken it
+	int latest;
+
+	int back;	// Owned by writer
+	int front;	// Owned by reader
+
+} RenderBuffer;
+
+// Cell arrays hold 'CELLS_MAX' cells, enough for any layout
+void RenderStateInit(RenderState *state, uint32_t item_capacity, uint32_t line_capacity, uint32_t projectile_capacity);
+void RenderStateClose(RenderState *state);
+
+void RenderBufferInit(RenderBuffer *buf, uint32_t item_capacity, uint32_t line_capacity, uint32_t projectile_capacity);
+void RenderBufferClose(RenderBuffer *buf);
+
+// Writer side
+RenderState *RenderBufferBack(RenderBuffer *buf);
+void RenderBufferPublish(RenderBuffer *buf);
+
+// Reader side, returns newest state available
+RenderState *RenderBufferAcquire(RenderBuffer *buf);
+
+uint8_t RenderLodTier(RenderLod *lod, float zoom);
+
+// Draw entities at tier of detail matching zoom, interpolated between last two ticks
+void RenderStateDraw(RenderState *state, Camera2D *camera, RenderLod *lod);
+
+void RenderGridDebugView(RenderState *state, Camera2D *camera);
+
+// Needs graphics context, starts fully transparent
+void CellTextureInit(CellTexture *ct, uint16_t cols, uint16_t rows);
+void CellTextureClose(CellTexture *ct);
+
+void CellTextureSet(CellTexture *ct, uint16_t c, uint16_t r, Color color);
+
+// Upload blocks changed since last upload with 'UpdateTextureRec()'
+void CellTextureUpload(CellTexture *ct);
+
+// Draw static scenery overlapping world space region
+void RenderStaticsDraw(RenderStaticLayer *statics, Rectangle region);
+
+#endif
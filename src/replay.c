@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "replay.h"
+#include "commands.h"
+#include "handler.h"
+#include "memory.h"
+
+#define write_field(_file, _val) fwrite(&(_val), sizeof(_val), 1, (_file))
+
+// Copy next field out of playback data, returns false if file is truncated
+static bool ReadField(Replay *replay, void *out, size_t size) {
+	if(replay->cursor + size > replay->size) return false;
+
+	memcpy(out, replay->data + replay->cursor, size);
+	replay->cursor += size;
+
+	return true;
+}
+
+// Read tick number of the next record
+static void ReplayReadNextTick(Replay *replay) {
+	if(!ReadField(replay, &replay->next_tick, sizeof(replay->next_tick)))
+		replay->next_tick = REPLAY_END_TICK;
+}
+
+bool ReplayRecordStart(Replay *replay, char *path, uint64_t seed, uint16_t tick_rate, const ReplayLevel *level) {
+	*replay = (Replay) { 0 };
+
+	replay->file = fopen(path, "wb");
+	if(!replay->file) {
+		printf("ERROR: Could not open replay file for writing at: %s\n", path);
+		return false;
+	}
+
+	replay->seed = seed;
+	replay->tick_rate = tick_rate;
+	replay->level = *level;
+
+	uint16_t version = REPLAY_VERSION;
+
+	fwrite(REPLAY_MAGIC, 1, 4, replay->file);
+	write_field(replay->file, version);
+	write_field(replay->file, tick_rate);
+	write_field(replay->file, seed);
+
+	write_field(replay->file, level->path);
+	write_field(replay->file, level->hash);
+	write_field(replay->file, level->grid_layout);
+	write_field(replay->file, level->vision_layout);
+	write_field(replay->file, level->grid_type);
+	write_field(replay->file, level->grid_cell_cap);
+
+	printf("Recording replay to: %s\n", path);
+	return true;
+}
+
+void ReplayRecordTick(Replay *replay, uint32_t tick, CommandBuffer *buf) {
+	if(!replay->file || !buf->commands.count) return;
+
+	uint16_t command_count = buf->commands.count;
+
+	write_field(replay->file, tick);
+	write_field(replay->file, command_count);
+
+	for(size_t i = 0; i < buf->commands.count; i++) {
+		Command *cmd = &buf->commands.data[i];
+		uint16_t unit_count = cmd->unit_count;
+
+		write_field(replay->file, cmd->order.type);
+		write_field(replay->file, cmd->flags);
+		write_field(replay->file, cmd->order.target.x);
+		write_field(replay->file, cmd->order.target.y);
+		write_field(replay->file, unit_count);
+
+		fwrite(&buf->units.data[cmd->unit_start], sizeof(INT_N), unit_count, replay->file);
+	}
+}
+
+void ReplayRecordEnd(Replay *replay, uint32_t tick, uint32_t checksum) {
+	if(!replay->file) return;
+
+	uint32_t end = REPLAY_END_TICK;
+
+	write_field(replay->file, end);
+	write_field(replay->file, tick);
+	write_field(replay->file, checksum);
+
+	fclose(replay->file);
+	replay->file = NULL;
+
+	replay->end_tick = tick;
+	replay->end_checksum = checksum;
+
+	printf("Replay saved: %d ticks, checksum %08x\n", tick, checksum);
+}
+
+bool ReplayLoad(Replay *replay, char *path) {
+	*replay = (Replay) { 0 };
+
+	FILE *pF = fopen(path, "rb");
+	if(!pF) {
+		printf("ERROR: Could not open replay file at: %s\n", path);
+		return false;
+	}
+
+	// Read whole file
+	fseek(pF, 0, SEEK_END);
+	replay->size = ftell(pF);
+	fseek(pF, 0, SEEK_SET);
+
+	replay->data = TrackedMalloc(replay->size);
+	replay->size = fread(replay->data, 1, replay->size, pF);
+	fclose(pF);
+
+	// Check header
+	char magic[4];
+	uint16_t version = 0;
+
+	bool valid = 
+		ReadField(replay, magic, sizeof(magic)) && 
+		ReadField(replay, &version, sizeof(version)) &&
+		ReadField(replay, &replay->tick_rate, sizeof(replay->tick_rate)) &&
+		ReadField(replay, &replay->seed, sizeof(replay->seed));
+
+	// Level and grid, only if version matches, older headers end before these
+	ReplayLevel *level = &replay->level;
+
+	valid = valid && version == REPLAY_VERSION &&
+		ReadField(replay, level->path, sizeof(level->path)) &&
+		ReadField(replay, &level->hash, sizeof(level->hash)) &&
+		ReadField(replay, &level->grid_layout, sizeof(level->grid_layout)) &&
+		ReadField(replay, &level->vision_layout, sizeof(level->vision_layout)) &&
+		ReadField(replay, &level->grid_type, sizeof(level->grid_type)) &&
+		ReadField(replay, &level->grid_cell_cap, sizeof(level->grid_cell_cap));
+
+	level->path[REPLAY_LEVEL_PATH_CAP - 1] = '\0';
+
+	if(!valid || memcmp(magic, REPLAY_MAGIC, 4) != 0 || version != REPLAY_VERSION) {
+		printf("ERROR: Invalid replay file: %s\n", path);
+		ReplayClose(replay);
+		return false;
+	}
+
+	// Read end marker from the last bytes of the file
+	size_t end_size = sizeof(uint32_t) * 3;
+	uint32_t end[3] = { 0 };
+
+	if(replay->size >= replay->cursor + end_size)
+		memcpy(end, replay->data + replay->size - end_size, end_size);
+
+	if(end[0] == REPLAY_END_TICK) {
+		replay->end_tick = end[1];
+		replay->end_checksum = end[2];
+	} else {
+		// Play until commands run out
+		printf("WARNING: Replay has no end marker, was recording interrupted?\n");
+		replay->end_tick = REPLAY_END_TICK;
+	}
+
+	ReplayReadNextTick(replay);
+	return true;
+}
+
+void ReplayFeedTick(Replay *replay, uint32_t tick, CommandBuffer *buf) {
+	if(replay->next_tick != tick) return;
+
+	uint16_t command_count = 0;
+	ReadField(replay, &command_count, sizeof(command_count));
+
+	for(uint16_t i = 0; i < command_count; i++) {
+		Order order = (Order) { 0 };
+		uint8_t flags = 0;
+		uint16_t unit_count = 0;
+
+		bool valid = 
+			ReadField(replay, &order.type, sizeof(order.type)) &&
+			ReadField(replay, &flags, sizeof(flags)) &&
+			ReadField(replay, &order.target.x, sizeof(order.target.x)) &&
+			ReadField(replay, &order.target.y, sizeof(order.target.y)) &&
+			ReadField(replay, &unit_count, sizeof(unit_count));
+
+		if(!valid || replay->cursor + unit_count * sizeof(INT_N) > replay->size) {
+			printf("ERROR: Replay data truncated at tick %d\n", tick);
+			replay->next_tick = REPLAY_END_TICK;
+			return;
+		}
+
+		// Copy unit ids into the buffer directly
+		vec_ent_grow(&buf->units, buf->units.count + unit_count);
+		memcpy(&buf->units.data[buf->units.count], replay->data + replay->cursor, unit_count * sizeof(INT_N));
+		replay->cursor += unit_count * sizeof(INT_N);
+
+		// Commands index entities by these, a corrupt file mustn't reach past them
+		for(uint16_t j = 0; j < unit_count; j++) {
+			INT_N id = buf->units.data[buf->units.count + j];
+			if(id >= 0 && id < ENTITY_CAP) continue;
+
+			printf("ERROR: Replay has invalid unit id %d at tick %d\n", id, tick);
+			replay->next_tick = REPLAY_END_TICK;
+			return;
+		}
+
+		vec_cmd_push(&buf->commands, (Command) {
+			.order = order,
+			.unit_start = buf->units.count,
+			.unit_count = unit_count,
+			.flags = flags
+		});
+
+		buf->units.count += unit_count;
+	}
+
+	ReplayReadNextTick(replay);
+}
+
+void ReplayClose(Replay *replay) {
+	if(replay->file) fclose(replay->file);
+	TrackedFree(replay->data);
+
+	*replay = (Replay) { 0 };
+}
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "commands.h"
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+// *
+// Replay file layout (native byte order):
+//
+// header:	magic "SRPL", u16 version, u16 tick rate, u64 seed,
+//			char level path[REPLAY_LEVEL_PATH_CAP], u32 level hash, CellLayout grid layout, CellLayout vision layout,
+//			u8 grid type, u8 grid cell cap
+// tick:	u32 tick, u16 command count, then per command:
+//			u8 order type, u8 flags, f32 target x, f32 target y, u16 unit count, i16 unit ids[]
+// end:		u32 REPLAY_END_TICK, u32 final tick, u32 state checksum
+//
+// Only ticks with commands are stored,
+// build commands ('CMD_BUILD') have the prefab index as order type and no units
+// *
+#define REPLAY_MAGIC		"SRPL"
+#define REPLAY_VERSION		2
+#define REPLAY_END_TICK		0xFFFFFFFF
+
+// Longest level path stored, including terminator
+#define REPLAY_LEVEL_PATH_CAP	128
+
+// *
+// Level and grid a recording ran on
+//
+// Grid settings come from the options file and change results (neighbours gathered in cell order,
+// entries dropped from full cells), so playback uses these instead of the current options.
+// Waves and scenery come from the level, its file has to hash the same.
+// *
+typedef struct {
+	char path[REPLAY_LEVEL_PATH_CAP];	// Empty if no level was loaded
+	uint32_t hash;						// 'LevelHash()' of file
+
+	CellLayout grid_layout;
+	CellLayout vision_layout;			// Fog of war and static layer
+	uint8_t grid_type;
+	uint8_t grid_cell_cap;
+
+} ReplayLevel;
+
+typedef struct {
+	// Recording
+	FILE *file;
+
+	// Playback, whole file is read into memory
+	uint8_t *data;
+	size_t size;
+	size_t cursor;
+
+	// Tick of the next stored record, REPLAY_END_TICK once all commands are fed
+	uint32_t next_tick;
+
+	// Final tick and checksum, known after loading or 'ReplayRecordEnd()'
+	uint32_t end_tick;
+	uint32_t end_checksum;
+
+	uint64_t seed;
+	uint16_t tick_rate;
+
+	ReplayLevel level;
+
+} Replay;
+
+bool ReplayRecordStart(Replay *replay, char *path, uint64_t seed, uint16_t tick_rate, const ReplayLevel *level);
+
+// Store commands about to be executed on 'tick'
+void ReplayRecordTick(Replay *replay, uint32_t tick, CommandBuffer *buf);
+
+// Write end marker and close file
+void ReplayRecordEnd(Replay *replay, uint32_t tick, uint32_t checksum);
+
+bool ReplayLoad(Replay *replay, char *path);
+
+// Push commands stored for 'tick' into buffer
+void ReplayFeedTick(Replay *replay, uint32_t tick, CommandBuffer *buf);
+
+void ReplayClose(Replay *replay);
+
+#endif
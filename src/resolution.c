@@ -0,0 +1,53 @@
+#include <stdint.h>
+#include <stdio.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "resolution.h"
+
+void DynResInit(DynamicResolution *dr, bool enabled, float min, float max, float refresh_rate) {
+	if(max < min) max = min;
+
+	*dr = (DynamicResolution) {
+		// Start at full quality, drop if needed
+		.scale = (enabled) ? max : 1.0f,
+		.min = min,
+		.max = max,
+		.target_ms = 1000.0f / refresh_rate,
+		.frame_ms = 1000.0f / refresh_rate,
+		.work_ms = 0,
+		.cooldown = DYNRES_COOLDOWN,
+		.hold = 0,
+		.enabled = enabled
+	};
+
+	if(enabled) printf("dynamic resolution: %.2f - %.2f, target %.2f ms\n", min, max, dr->target_ms);
+}
+
+bool DynResUpdate(DynamicResolution *dr, float frame_time, float work_ms) {
+	if(!dr->enabled) return false;
+
+	dr->frame_ms += (frame_time * 1000.0f - dr->frame_ms) * DYNRES_SMOOTHING;
+	dr->work_ms += (work_ms - dr->work_ms) * DYNRES_SMOOTHING;
+
+	dr->cooldown -= frame_time;
+	dr->hold -= frame_time;
+
+	if(dr->cooldown > 0) return false;
+
+	float scale = dr->scale;
+
+	if(dr->frame_ms > dr->target_ms * DYNRES_MISS) {
+		scale -= DYNRES_STEP;
+		dr->hold = DYNRES_HOLD;
+
+	} else if(dr->hold <= 0 && dr->work_ms < dr->target_ms * DYNRES_HEADROOM)
+		scale += DYNRES_STEP;
+
+	scale = Clamp(scale, dr->min, dr->max);
+	if(scale == dr->scale) return false;
+
+	dr->scale = scale;
+	dr->cooldown = DYNRES_COOLDOWN;
+
+	return true;
+}
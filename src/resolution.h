@@ -0,0 +1,59 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef RESOLUTION_H_
+#define RESOLUTION_H_
+
+// Scale change per adjustment
+#define DYNRES_STEP			0.1f
+
+// Seconds between adjustments, gives smoothed timings time to settle
+#define DYNRES_COOLDOWN		0.5f
+
+// Seconds scale isn't raised again after having to lower it, stops oscillating
+#define DYNRES_HOLD			3.0f
+
+// Weight of the newest sample in smoothed timings
+#define DYNRES_SMOOTHING	0.1f
+
+// Frame time over budget by this factor counts as missing the refresh rate
+#define DYNRES_MISS			1.1f
+
+// Raise scale only while frame work fits in this share of the budget
+#define DYNRES_HEADROOM		0.7f
+
+// *
+// Dynamic resolution
+//
+// Game is always drawn in virtual units, only the part of the render target
+// drawn into changes size. Camera, cursor and selection math never see the scale.
+// Frame time (including present) decides when to lower resolution,
+// time spent on frame work (excluding vsync wait) decides when there's room to raise it.
+// *
+typedef struct {
+	// Render target pixels per virtual pixel
+	float scale;
+
+	float min;
+	float max;
+
+	// Frame budget from refresh rate
+	float target_ms;
+
+	// Smoothed timings
+	float frame_ms;
+	float work_ms;
+
+	float cooldown;
+	float hold;
+
+	bool enabled;
+
+} DynamicResolution;
+
+void DynResInit(DynamicResolution *dr, bool enabled, float min, float max, float refresh_rate);
+
+// Feed last frame's timings, returns true if scale changed
+bool DynResUpdate(DynamicResolution *dr, float frame_time, float work_ms);
+
+#endif
@@ -0,0 +1,249 @@
+#include <stdint.h>
+#include <string.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "handler.h"
+#include "memory.h"
+
+// Grid cells are from the start of last tick, units have moved less than this since
+#define SELECT_QUERY_SLACK	(UNIT_SPEED * 0.1f)
+
+void SelectionInit(Selection *sel) {
+	sel->ids = TrackedCalloc(ENTITY_CAP, sizeof(INT_N));
+	sel->index = TrackedCalloc(ENTITY_CAP, sizeof(INT_N));
+	sel->group_bits = TrackedCalloc(ENTITY_CAP, sizeof(uint16_t));
+	sel->count = 0;
+
+	for(INT_N i = 0; i < ENTITY_CAP; i++)
+		sel->index[i] = -1;
+
+	for(uint8_t i = 0; i < CONTROL_GROUP_COUNT; i++)
+		vec_ent_init(&sel->groups[i], 0);
+}
+
+void SelectionClose(Selection *sel) {
+	TrackedFree(sel->ids);
+	TrackedFree(sel->index);
+	TrackedFree(sel->group_bits);
+
+	for(uint8_t i = 0; i < CONTROL_GROUP_COUNT; i++)
+		vec_ent_free(&sel->groups[i]);
+}
+
+static comp_Selectable *SelectableOf(Handler *handler, INT_N entity_id) {
+	return HandlerGetComponent(handler, entity_id, COMP_SELECTABLE);
+}
+
+void SelectionClear(Handler *handler) {
+	Selection *sel = &handler->selection;
+
+	for(INT_N i = 0; i < sel->count; i++) {
+		SelectableOf(handler, sel->ids[i])->flags &= ~SELECTED;
+		sel->index[sel->ids[i]] = -1;
+	}
+
+	sel->count = 0;
+}
+
+bool SelectionAdd(Handler *handler, INT_N entity_id) {
+	Selection *sel = &handler->selection;
+	if(sel->index[entity_id] >= 0) return false;
+
+	comp_Selectable *selectable = SelectableOf(handler, entity_id);
+	if(!selectable) return false;
+
+	selectable->flags |= SELECTED;
+	sel->index[entity_id] = sel->count;
+	sel->ids[sel->count++] = entity_id;
+
+	return true;
+}
+
+bool SelectionRemove(Handler *handler, INT_N entity_id) {
+	Selection *sel = &handler->selection;
+
+	INT_N slot = sel->index[entity_id];
+	if(slot < 0) return false;
+
+	SelectableOf(handler, entity_id)->flags &= ~SELECTED;
+
+	// Last id fills the gap
+	INT_N last = sel->ids[--sel->count];
+	sel->ids[slot] = last;
+	sel->index[last] = slot;
+	sel->index[entity_id] = -1;
+
+	return true;
+}
+
+void SelectionForget(Handler *handler, INT_N entity_id) {
+	Selection *sel = &handler->selection;
+
+	SelectionRemove(handler, entity_id);
+
+	for(uint16_t bits = sel->group_bits[entity_id]; bits; bits &= bits - 1) {
+		vec_ent *group = &sel->groups[__builtin_ctz(bits)];
+
+		for(size_t i = 0; i < group->count; i++) {
+			if(group->data[i] != entity_id) continue;
+
+			group->data[i] = group->data[--group->count];
+			break;
+		}
+	}
+
+	sel->group_bits[entity_id] = 0;
+}
+
+void SelectionRebuild(Handler *handler) {
+	Selection *sel = &handler->selection;
+
+	for(INT_N i = 0; i < ENTITY_CAP; i++)
+		sel->index[i] = -1;
+
+	sel->count = 0;
+
+	for(INT_N i = 0; i < handler->entity_count; i++) {
+		comp_Selectable *selectable = SelectableOf(handler, i);
+		if(!selectable || !(selectable->flags & SELECTED)) continue;
+
+		sel->index[i] = sel->count;
+		sel->ids[sel->count++] = i;
+	}
+
+	// Groups may point at entities that don't exist in this state
+	memset(sel->group_bits, 0, ENTITY_CAP * sizeof(uint16_t));
+
+	for(uint8_t g = 0; g < CONTROL_GROUP_COUNT; g++) {
+		vec_ent *group = &sel->groups[g];
+		size_t kept = 0;
+
+		for(size_t i = 0; i < group->count; i++) {
+			INT_N id = group->data[i];
+			if(id >= handler->entity_count || !SelectableOf(handler, id)) continue;
+
+			group->data[kept++] = id;
+			sel->group_bits[id] |= (1 << g);
+		}
+
+		group->count = kept;
+	}
+}
+
+static void SelectApply(Handler *handler, INT_N entity_id, uint8_t mode) {
+	if(mode == SELECT_REMOVE) SelectionRemove(handler, entity_id);
+	else SelectionAdd(handler, entity_id);
+}
+
+// Selectable units with their center near 'rec', candidates come from grid cells around it
+static void SelectCandidates(Handler *handler, Rectangle rec, vec_ent *out) {
+	float margin = SELECT_RADIUS + SELECT_QUERY_SLACK;
+
+	Rectangle query = (Rectangle) {
+		.x = rec.x - margin,
+		.y = rec.y - margin,
+		.width = rec.width + margin * 2,
+		.height = rec.height + margin * 2
+	};
+
+	vec_ent cells;
+	vec_ent_init_arena(&cells, handler->arena, 0);
+	GridQueryRec(&handler->grid, query, &cells);
+
+	for(size_t i = 0; i < cells.count; i++) {
+		INT_N id = cells.data[i];
+		comp_Transform *transform = HandlerGetComponent(handler, id, COMP_TRANSFORM);
+
+		if(!transform || !SelectableOf(handler, id)) continue;
+		if(!CheckCollisionCircleRec(transform->position, SELECT_RADIUS, rec)) continue;
+
+		vec_ent_push(out, id);
+	}
+}
+
+void SelectBox(Handler *handler, Rectangle rec, uint8_t mode) {
+	ArenaMark mark = ArenaGetMark(handler->arena);
+
+	vec_ent found;
+	vec_ent_init_arena(&found, handler->arena, 0);
+	SelectCandidates(handler, rec, &found);
+
+	if(mode == SELECT_REPLACE) SelectionClear(handler);
+
+	for(size_t i = 0; i < found.count; i++)
+		SelectApply(handler, found.data[i], mode);
+
+	ArenaRewind(handler->arena, mark);
+}
+
+void SelectSameType(Handler *handler, Vector2 point, Rectangle view, uint8_t mode) {
+	ArenaMark mark = ArenaGetMark(handler->arena);
+
+	// Unit closest to the click
+	vec_ent found;
+	vec_ent_init_arena(&found, handler->arena, 0);
+	SelectCandidates(handler, (Rectangle) { point.x, point.y, 0, 0 }, &found);
+
+	INT_N clicked = -1;
+	float best = 0;
+
+	for(size_t i = 0; i < found.count; i++) {
+		comp_Transform *transform = HandlerGetComponent(handler, found.data[i], COMP_TRANSFORM);
+		float dist = Vector2DistanceSqr(transform->position, point);
+
+		if(clicked < 0 || dist < best) {
+			clicked = found.data[i];
+			best = dist;
+		}
+	}
+
+	comp_Sprite *type = (clicked >= 0) ? HandlerGetComponent(handler, clicked, COMP_SPRITE) : NULL;
+
+	if(type) {
+		uint16_t sprite_id = type->sprite_id;
+
+		vec_ent_clear(&found);
+		SelectCandidates(handler, view, &found);
+
+		if(mode == SELECT_REPLACE) SelectionClear(handler);
+
+		for(size_t i = 0; i < found.count; i++) {
+			comp_Sprite *sprite = HandlerGetComponent(handler, found.data[i], COMP_SPRITE);
+			if(sprite && sprite->sprite_id == sprite_id) SelectApply(handler, found.data[i], mode);
+		}
+	}
+
+	ArenaRewind(handler->arena, mark);
+}
+
+void GroupAssign(Handler *handler, uint8_t group) {
+	Selection *sel = &handler->selection;
+	if(group >= CONTROL_GROUP_COUNT) return;
+
+	vec_ent *ids = &sel->groups[group];
+
+	for(size_t i = 0; i < ids->count; i++)
+		sel->group_bits[ids->data[i]] &= ~(1 << group);
+
+	vec_ent_clear(ids);
+	vec_ent_append(ids, sel->ids, sel->count);
+
+	for(INT_N i = 0; i < sel->count; i++)
+		sel->group_bits[sel->ids[i]] |= (1 << group);
+}
+
+void GroupRecall(Handler *handler, uint8_t group, uint8_t mode) {
+	Selection *sel = &handler->selection;
+	if(group >= CONTROL_GROUP_COUNT) return;
+
+	if(mode == SELECT_REPLACE) SelectionClear(handler);
+
+	vec_ent *ids = &sel->groups[group];
+
+	for(size_t i = 0; i < ids->count; i++)
+		SelectApply(handler, ids->data[i], mode);
+}
+
+void GetSelectedUnits(Handler *handler, vec_ent *out) {
+	vec_ent_append(out, handler->selection.ids, handler->selection.count);
+}
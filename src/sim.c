@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+#include "handler.h"
+#include "commands.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "input.h"
+#include "render.h"
+#include "level.h"
+#include "memory.h"
+#include "raylib.h"
+#include "profiler.h"
+#include <pthread.h>
+
+// Arena size for a tick's transient allocations
+#define SIM_ARENA_SIZE	(256 * 1024)
+
+// Longest sleep while waiting for the next tick, keeps input latency low
+#define SIM_THREAD_MAX_WAIT	0.002
+
+void SimInit(Sim *sim, uint16_t tick_rate) {
+	*sim = (Sim) {
+		.accumulator = 0,
+		.tick_rate = (tick_rate) ? tick_rate : SIM_DEFAULT_TICK_RATE,
+		.flags = 0
+	};
+
+	SnapshotHistoryInit(&sim->history, sim->tick_rate * SIM_HISTORY_INTERVAL);
+	ArenaInit(&sim->tick_arena, SIM_ARENA_SIZE);
+}
+
+void SimClose(Sim *sim, Handler *handler) {
+	if(sim->flags & SIM_RECORDING) 
+		ReplayRecordEnd(&sim->replay, handler->tick, HandlerChecksum(handler));
+
+	ReplayClose(&sim->replay);
+	SnapshotHistoryClose(&sim->history);
+	SnapshotClose(&sim->save);
+	ArenaClose(&sim->tick_arena);
+
+	sim->flags = 0;
+}
+
+void SimStep(Sim *sim, Handler *handler, CommandBuffer *commands) {
+	ArenaReset(&sim->tick_arena);
+
+	// Replace live input with recorded commands
+	if(sim->flags & SIM_PLAYBACK) {
+		CommandBufferClear(commands);
+		ReplayFeedTick(&sim->replay, handler->tick, commands);
+	}
+
+	if(sim->flags & SIM_RECORDING) 
+		ReplayRecordTick(&sim->replay, handler->tick, commands);
+
+	CommandsExecute(commands, handler);
+	HandlerUpdate(handler, 1.0f / sim->tick_rate);
+
+	handler->tick++;
+
+	// Keep history and autosaves during live play only,
+	// replays start from a fresh state and can't be rewound
+	if(!(sim->flags & (SIM_RECORDING | SIM_PLAYBACK))) {
+		SnapshotHistoryUpdate(&sim->history, handler);
+
+		if(handler->tick % (sim->tick_rate * SIM_AUTOSAVE_INTERVAL) == 0) 
+			SimSave(sim, handler, SIM_AUTOSAVE_PATH);
+	}
+
+	// Stop playback at the end of the recording
+	if((sim->flags & SIM_PLAYBACK) && handler->tick >= sim->replay.end_tick) {
+		uint32_t checksum = HandlerChecksum(handler);
+		bool match = (checksum == sim->replay.end_checksum);
+
+		printf("Replay finished at tick %d, checksum %08x (%s)\n", handler->tick, checksum, (match) ? "match" : "DESYNC");
+		sim->flags &= ~SIM_PLAYBACK;
+	}
+}
+
+bool SimAdvance(Sim *sim, Handler *handler, CommandBuffer *commands, float frame_time) {
+	float tick_dt = 1.0f / sim->tick_rate;
+	sim->accumulator += frame_time;
+
+	// Drop time that can't be caught up on
+	float max_time = tick_dt * SIM_MAX_TICKS_PER_FRAME;
+	if(sim->accumulator > max_time) sim->accumulator = max_time;
+
+	bool ticked = false;
+
+	while(sim->accumulator >= tick_dt) {
+		SimStep(sim, handler, commands);
+		sim->accumulator -= tick_dt;
+
+		ticked = true;
+	}
+
+	return ticked;
+}
+
+void SimProcessInput(Sim *sim, Handler *handler, CommandBuffer *commands, InputEvent *event) {
+	switch(event->type) {
+		case INPUT_SELECT:			SelectBox(handler, event->rec, event->flags);							break;
+		case INPUT_SELECT_TYPE:		SelectSameType(handler, event->order.target, event->rec, event->flags);	break;
+		case INPUT_GROUP_ASSIGN:	GroupAssign(handler, event->group);										break;
+		case INPUT_GROUP_SELECT:	GroupRecall(handler, event->group, event->flags);						break;
+
+		// Resolve selection now, commands carry explicit unit ids
+		case INPUT_ORDER:
+			CommandPush(commands, event->order, handler->selection.ids, handler->selection.count, event->flags);
+			break;
+
+		case INPUT_SAVE:	SimSave(sim, handler, SIM_QUICKSAVE_PATH);						break;
+		case INPUT_LOAD:	SimLoad(sim, handler, commands, SIM_QUICKSAVE_PATH);			break;
+		case INPUT_REWIND:	SimRewind(sim, handler, commands, event->amount);				break;
+		case INPUT_BUILD:	CommandPushBuild(commands, event->prefab, event->order.target);	break;
+		case INPUT_TICK_RATE:	SimSetTickRate(sim, event->amount);							break;
+		case INPUT_GRID:	SimSetGrid(sim, handler, event->amount, event->cell_cap);		break;
+	}
+}
+
+void SimDrainInput(Sim *sim, Handler *handler, CommandBuffer *commands, InputQueue *input) {
+	InputEvent event;
+
+	while(InputQueuePop(input, &event)) 
+		SimProcessInput(sim, handler, commands, &event);
+}
+
+void SimPublish(Sim *sim, Handler *handler, RenderBuffer *render, double time) {
+	RenderState *state = RenderBufferBack(render);
+
+	HandlerCaptureRenderState(handler, state);
+	state->time = time;
+	state->tick_rate = sim->tick_rate;
+
+	RenderBufferPublish(render);
+}
+
+static void *SimThreadMain(void *arg) {
+	SimThread *st = arg;
+	double next_tick = GetTime();
+
+	while(__atomic_load_n(&st->running, __ATOMIC_ACQUIRE)) {
+		SimDrainInput(st->sim, st->handler, st->commands, st->input);
+
+		// Wait for next tick
+		double now = GetTime();
+		if(now < next_tick) {
+			double wait = next_tick - now;
+			WaitTime((wait < SIM_THREAD_MAX_WAIT) ? wait : SIM_THREAD_MAX_WAIT);
+			continue;
+		}
+
+		ProfileBegin(PROF_SIM);
+		SimStep(st->sim, st->handler, st->commands);
+		ProfileEnd(PROF_SIM);
+
+		// Fall behind rather than spiral when ticks take too long
+		double tick_dt = 1.0 / st->sim->tick_rate;
+		next_tick += tick_dt;
+		if(now - next_tick > tick_dt * SIM_MAX_TICKS_PER_FRAME) next_tick = now;
+
+		SimPublish(st->sim, st->handler, st->render, next_tick - tick_dt);
+	}
+
+	return NULL;
+}
+
+bool SimThreadStart(SimThread *st) {
+	st->running = 1;
+
+	if(pthread_create(&st->thread, NULL, SimThreadMain, st) != 0) {
+		puts("ERROR: Could not start simulation thread");
+		st->running = 0;
+		return false;
+	}
+
+	return true;
+}
+
+void SimThreadStop(SimThread *st) {
+	if(!st->running) return;
+
+	__atomic_store_n(&st->running, 0, __ATOMIC_RELEASE);
+	pthread_join(st->thread, NULL);
+}
+
+bool SimSetTickRate(Sim *sim, uint16_t tick_rate) {
+	if(!tick_rate || tick_rate == sim->tick_rate) return false;
+
+	if(sim->flags & (SIM_RECORDING | SIM_PLAYBACK)) {
+		puts("WARNING: Tick rate can't change while recording or replaying");
+		return false;
+	}
+
+	sim->tick_rate = tick_rate;
+	printf("tick rate: %d\n", tick_rate);
+
+	// History steps are counted in ticks, older ones would rewind by the wrong time
+	SnapshotHistoryClose(&sim->history);
+	SnapshotHistoryInit(&sim->history, sim->tick_rate * SIM_HISTORY_INTERVAL);
+
+	return true;
+}
+
+bool SimSetGrid(Sim *sim, Handler *handler, float cell_size, uint8_t cell_cap) {
+	GridTuning *tuning = &handler->grid_tuning;
+
+	if(!cell_size || !cell_cap || (cell_size == tuning->cell_size && cell_cap == tuning->cell_cap)) return false;
+	if(sim->flags & (SIM_RECORDING | SIM_PLAYBACK)) {
+		puts("WARNING: Grid can't change while recording or replaying");
+		return false;
+	}
+
+	// Rebuilt on next tick, entities are binned by previous position until then
+	tuning->cell_size = cell_size;
+	tuning->cell_cap = cell_cap;
+	tuning->refit = true;
+
+	return true;
+}
+
+bool SimRecord(Sim *sim, Handler *handler, char *path, uint64_t seed, char *level_path) {
+	// Grid fit changes results, store it with the level it came from
+	ReplayLevel level = {
+		.grid_layout = handler->grid.layout,
+		.vision_layout = handler->visibility.layout,
+		.grid_type = handler->grid.type,
+		.grid_cell_cap = handler->grid.cell_cap
+	};
+
+	if(level_path) {
+		if(strlen(level_path) >= REPLAY_LEVEL_PATH_CAP) {
+			printf("ERROR: Level path too long to record: %s\n", level_path);
+			return false;
+		}
+
+		strcpy(level.path, level_path);
+		level.hash = LevelHash(level_path);
+	}
+
+	if(!ReplayRecordStart(&sim->replay, path, seed, sim->tick_rate, &level)) return false;
+
+	sim->flags |= SIM_RECORDING;
+	return true;
+}
+
+bool SimPlayback(Sim *sim, char *path) {
+	if(!ReplayLoad(&sim->replay, path)) return false;
+
+	// Waves and scenery come from the level, it has to be the recorded one
+	ReplayLevel *level = &sim->replay.level;
+
+	if(level->path[0] && LevelHash(level->path) != level->hash) {
+		printf("ERROR: Level file missing or changed since recording: %s\n", level->path);
+		ReplayClose(&sim->replay);
+		return false;
+	}
+
+	// Tick rate is part of the simulation, use recorded one
+	sim->tick_rate = sim->replay.tick_rate;
+	sim->flags |= SIM_PLAYBACK;
+
+	return true;
+}
+
+void SimPinGrid(Sim *sim, Handler *handler) {
+	ReplayLevel *level = &sim->replay.level;
+	GridTuning *tuning = &handler->grid_tuning;
+
+	tuning->pinned = true;
+	tuning->pinned_type = level->grid_type;
+	tuning->pinned_grid = level->grid_layout;
+	tuning->pinned_level = level->vision_layout;
+	tuning->cell_cap = level->grid_cell_cap;
+	tuning->auto_tune = false;
+}
+
+bool SimSave(Sim *sim, Handler *handler, char *path) {
+	SnapshotCapture(&sim->save, handler);
+	return SnapshotSaveFile(&sim->save, path);
+}
+
+bool SimLoad(Sim *sim, Handler *handler, CommandBuffer *commands, char *path) {
+	if(sim->flags & (SIM_RECORDING | SIM_PLAYBACK)) {
+		puts("Can't load a snapshot while recording or playing a replay");
+		return false;
+	}
+
+	if(!SnapshotLoadFile(&sim->save, path)) return false;
+	if(!SnapshotRestore(&sim->save, handler)) return false;
+
+	CommandBufferClear(commands);
+	SnapshotHistoryReset(&sim->history);
+	sim->accumulator = 0;
+
+	printf("Loaded snapshot %s at tick %d\n", path, handler->tick);
+	return true;
+}
+
+bool SimRewind(Sim *sim, Handler *handler, CommandBuffer *commands, float seconds) {
+	if(sim->flags & (SIM_RECORDING | SIM_PLAYBACK)) return false;
+
+	float steps = seconds / SIM_HISTORY_INTERVAL;
+	if(!SnapshotHistoryRewind(&sim->history, handler, (steps > 255) ? 255 : (uint8_t)steps)) return false;
+
+	CommandBufferClear(commands);
+	sim->accumulator = 0;
+
+	return true;
+}
+
+int SimRunHeadless(Sim *sim, Handler *handler, CommandBuffer *commands) {
+	if(!(sim->flags & SIM_PLAYBACK)) return 1;
+
+	uint32_t end_tick = sim->replay.end_tick;
+	bool has_end = (end_tick != REPLAY_END_TICK);
+	clock_t start = clock();
+
+	// Run until replay stops itself, or commands run out if it has no end marker
+	while(sim->flags & SIM_PLAYBACK) {
+		if(!has_end && sim->replay.next_tick == REPLAY_END_TICK) break;
+		SimStep(sim, handler, commands);
+	}
+
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	printf("Simulated %d ticks in %.3f s (%.0f ticks/s)\n", handler->tick, seconds, (seconds > 0) ? handler->tick / seconds : 0);
+
+	if(!has_end) return 1;
+
+	return (HandlerChecksum(handler) == sim->replay.end_checksum) ? 0 : 1;
+}
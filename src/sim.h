@@ -0,0 +1,136 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "handler.h"
+#include "commands.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "input.h"
+#include "render.h"
+#include "memory.h"
+#include <pthread.h>
+
+#ifndef SIM_H_
+#define SIM_H_
+
+// Default simulation ticks per second
+#define SIM_DEFAULT_TICK_RATE	60
+
+// Most ticks run in a single frame, time past that is dropped
+#define SIM_MAX_TICKS_PER_FRAME	8
+
+// Seed used when none is given
+#define SIM_DEFAULT_SEED		0x5EED5EEDull
+
+// Seconds between rewind history captures (per second of history: 1 / this)
+#define SIM_HISTORY_INTERVAL	0.5f
+
+// Seconds between automatic saves, for crash recovery
+#define SIM_AUTOSAVE_INTERVAL	30
+
+#define SIM_QUICKSAVE_PATH		"quicksave.snap"
+#define SIM_AUTOSAVE_PATH		"autosave.snap"
+
+// Sim flags
+#define SIM_RECORDING	0x01
+#define SIM_PLAYBACK	0x02
+
+// Fixed tick simulation driver
+// Runs 'HandlerUpdate()' at a constant rate independent of frame time,
+// inputs reach the handler only as commands executed at the start of a tick
+typedef struct {
+	Replay replay;
+
+	// Past states for rewinding, not captured while recording or playing replays
+	SnapshotHistory history;
+
+	// Buffer for saving and loading
+	Snapshot save;
+
+	// Transient allocations, reset at the start of every tick
+	Arena tick_arena;
+
+	// Frame time not yet simulated
+	float accumulator;
+
+	uint16_t tick_rate;
+	uint8_t flags;
+
+} Sim;
+
+void SimInit(Sim *sim, uint16_t tick_rate);
+
+// Finish recording (if any), free replay data
+void SimClose(Sim *sim, Handler *handler);
+
+// Run a single tick:
+// feed replay or record commands, execute commands, update handler
+void SimStep(Sim *sim, Handler *handler, CommandBuffer *commands);
+
+// Run as many ticks as fit in elapsed frame time
+// Returns true if any tick was run
+bool SimAdvance(Sim *sim, Handler *handler, CommandBuffer *commands, float frame_time);
+
+// Apply a player action: selection, orders, save states
+void SimProcessInput(Sim *sim, Handler *handler, CommandBuffer *commands, InputEvent *event);
+
+// Process all queued player actions
+void SimDrainInput(Sim *sim, Handler *handler, CommandBuffer *commands, InputQueue *input);
+
+// Copy current state into back render buffer and publish it
+// 'time' is when the state became current, for interpolation
+void SimPublish(Sim *sim, Handler *handler, RenderBuffer *render, double time);
+
+// Record commands to file, call before first tick
+// 'level_path' is the level loaded into 'handler', NULL if none
+bool SimRecord(Sim *sim, Handler *handler, char *path, uint64_t seed, char *level_path);
+
+// Load replay, live input is ignored while playing
+// Fails if replay's level file is missing or changed
+// Handler must be initialized with replay's seed and grid ('SimPinGrid()') after this
+bool SimPlayback(Sim *sim, char *path);
+
+// Make handler fit its grid like the replay being played did
+void SimPinGrid(Sim *sim, Handler *handler);
+
+// Save state to file
+bool SimSave(Sim *sim, Handler *handler, char *path);
+
+// Load state from file, pending commands and rewind history are dropped
+bool SimLoad(Sim *sim, Handler *handler, CommandBuffer *commands, char *path);
+
+// Go back in time by roughly 'seconds', limited by history length
+bool SimRewind(Sim *sim, Handler *handler, CommandBuffer *commands, float seconds);
+
+// Change ticks per second, refused while recording or replaying since replays store one rate
+// Rewind history is dropped, it was kept at the old rate
+bool SimSetTickRate(Sim *sim, uint16_t tick_rate);
+
+// Change grid cell size and cap, not while recording or replaying
+// Grid is rebuilt over the same area next tick, fog of war and scenery keep the level layout
+bool SimSetGrid(Sim *sim, Handler *handler, float cell_size, uint8_t cell_cap);
+
+// Simulation running on its own thread
+// While running, the thread owns sim, handler and commands exclusively,
+// input arrives through the queue and results leave through the render buffer
+typedef struct {
+	Sim *sim;
+	Handler *handler;
+	CommandBuffer *commands;
+	InputQueue *input;
+	RenderBuffer *render;
+
+	pthread_t thread;
+	uint8_t running;
+
+} SimThread;
+
+bool SimThreadStart(SimThread *st);
+
+// Signal thread to stop and wait for it
+void SimThreadStop(SimThread *st);
+
+// Play loaded replay to the end as fast as possible, no window needed
+// Returns 0 if final state matches the recording
+int SimRunHeadless(Sim *sim, Handler *handler, CommandBuffer *commands);
+
+#endif
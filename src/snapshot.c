@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "snapshot.h"
+#include "handler.h"
+#include "memory.h"
+
+static void SnapshotReserve(Snapshot *snap, size_t capacity) {
+	if(capacity <= snap->capacity) return;
+
+	snap->data = TrackedRealloc(snap->data, capacity);
+	snap->capacity = capacity;
+}
+
+static void SnapshotCopy(Snapshot *dst, Snapshot *src) {
+	SnapshotReserve(dst, src->size);
+	memcpy(dst->data, src->data, src->size);
+	dst->size = src->size;
+}
+
+void SnapshotClose(Snapshot *snap) {
+	TrackedFree(snap->data);
+	*snap = (Snapshot) { 0 };
+}
+
+void SnapshotCapture(Snapshot *snap, Handler *handler) {
+	snap->size = HandlerSnapshotSize(handler);
+	SnapshotReserve(snap, snap->size);
+
+	HandlerSnapshotWrite(handler, snap->data);
+}
+
+bool SnapshotRestore(Snapshot *snap, Handler *handler) {
+	return HandlerSnapshotRead(handler, snap->data, snap->size);
+}
+
+void SnapshotDelta(Snapshot *base, Snapshot *target, Snapshot *delta) {
+	// Worst case: a run header for every (1 changed + gap) bytes
+	SnapshotReserve(delta, sizeof(uint32_t) + target->size * 2 + sizeof(uint32_t) * 2);
+
+	uint8_t *b = base->data;
+	uint8_t *t = target->data;
+	uint8_t *out = delta->data;
+
+	uint32_t target_size = target->size;
+	memcpy(out, &target_size, sizeof(uint32_t));
+	out += sizeof(uint32_t);
+
+	size_t common = (base->size < target->size) ? base->size : target->size;
+	size_t i = 0;
+
+	while(i < target->size) {
+		// Skip unchanged bytes
+		while(i < common && b[i] == t[i]) i++;
+		if(i >= target->size) break;
+
+		// Extend run until a long enough unchanged gap
+		size_t start = i;
+		size_t end = i;
+
+		while(i < target->size) {
+			bool same = (i < common && b[i] == t[i]);
+
+			if(!same) end = i + 1;
+			else if(i + 1 - end >= SNAPSHOT_DELTA_MIN_GAP) break;
+
+			i++;
+		}
+
+		uint32_t run[2] = { start, end - start };
+		memcpy(out, run, sizeof(run));
+		out += sizeof(run);
+
+		memcpy(out, t + start, end - start);
+		out += end - start;
+
+		i = end;
+	}
+
+	delta->size = out - delta->data;
+}
+
+bool SnapshotApplyDelta(Snapshot *snap, Snapshot *delta) {
+	if(delta->size < sizeof(uint32_t)) return false;
+
+	uint8_t *in = delta->data;
+	uint8_t *in_end = delta->data + delta->size;
+
+	uint32_t target_size;
+	memcpy(&target_size, in, sizeof(uint32_t));
+	in += sizeof(uint32_t);
+
+	SnapshotReserve(snap, target_size);
+	snap->size = target_size;
+
+	while(in < in_end) {
+		uint32_t run[2];
+		if(in + sizeof(run) > in_end) return false;
+
+		memcpy(run, in, sizeof(run));
+		in += sizeof(run);
+
+		if(run[0] + run[1] > target_size || in + run[1] > in_end) return false;
+
+		memcpy(snap->data + run[0], in, run[1]);
+		in += run[1];
+	}
+
+	return true;
+}
+
+bool SnapshotSaveFile(Snapshot *snap, char *path) {
+	FILE *pF = fopen(path, "wb");
+	if(!pF) {
+		printf("ERROR: Could not open snapshot file for writing at: %s\n", path);
+		return false;
+	}
+
+	size_t written = fwrite(snap->data, 1, snap->size, pF);
+	fclose(pF);
+
+	return (written == snap->size);
+}
+
+bool SnapshotLoadFile(Snapshot *snap, char *path) {
+	FILE *pF = fopen(path, "rb");
+	if(!pF) {
+		printf("ERROR: Could not open snapshot file at: %s\n", path);
+		return false;
+	}
+
+	fseek(pF, 0, SEEK_END);
+	size_t size = ftell(pF);
+	fseek(pF, 0, SEEK_SET);
+
+	SnapshotReserve(snap, size);
+	snap->size = fread(snap->data, 1, size, pF);
+	fclose(pF);
+
+	return (snap->size == size);
+}
+
+void SnapshotHistoryInit(SnapshotHistory *history, uint32_t interval) {
+	*history = (SnapshotHistory) { 0 };
+	history->interval = (interval) ? interval : 1;
+}
+
+void SnapshotHistoryClose(SnapshotHistory *history) {
+	SnapshotClose(&history->latest);
+	SnapshotClose(&history->scratch);
+
+	for(uint8_t i = 0; i < SNAPSHOT_HISTORY_CAP; i++)
+		SnapshotClose(&history->deltas[i]);
+
+	history->count = 0;
+	history->has_latest = false;
+}
+
+void SnapshotHistoryReset(SnapshotHistory *history) {
+	history->head = 0;
+	history->count = 0;
+	history->has_latest = false;
+}
+
+void SnapshotHistoryUpdate(SnapshotHistory *history, Handler *handler) {
+	if(handler->tick % history->interval != 0) return;
+
+	SnapshotCapture(&history->scratch, handler);
+
+	// Store how to get back from the new state to the previous one
+	if(history->has_latest) {
+		history->head = (history->head + 1) % SNAPSHOT_HISTORY_CAP;
+		SnapshotDelta(&history->scratch, &history->latest, &history->deltas[history->head]);
+
+		if(history->count < SNAPSHOT_HISTORY_CAP) history->count++;
+	}
+
+	// New state becomes latest, swap buffers instead of copying
+	Snapshot tmp = history->latest;
+	history->latest = history->scratch;
+	history->scratch = tmp;
+
+	history->has_latest = true;
+}
+
+bool SnapshotHistoryRewind(SnapshotHistory *history, Handler *handler, uint8_t steps) {
+	if(!history->has_latest) return false;
+	if(steps > history->count) steps = history->count;
+
+	// Walk back from latest state
+	SnapshotCopy(&history->scratch, &history->latest);
+
+	for(uint8_t i = 0; i < steps; i++) {
+		uint8_t idx = (history->head + SNAPSHOT_HISTORY_CAP - i) % SNAPSHOT_HISTORY_CAP;
+		if(!SnapshotApplyDelta(&history->scratch, &history->deltas[idx])) return false;
+	}
+
+	if(!SnapshotRestore(&history->scratch, handler)) return false;
+
+	// Restored state is the new latest, drop the deltas that led past it
+	Snapshot tmp = history->latest;
+	history->latest = history->scratch;
+	history->scratch = tmp;
+
+	history->head = (history->head + SNAPSHOT_HISTORY_CAP - steps) % SNAPSHOT_HISTORY_CAP;
+	history->count -= steps;
+
+	return true;
+}
@@ -0,0 +1,76 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "handler.h"
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+// Number of past states kept for rewinding
+#define SNAPSHOT_HISTORY_CAP	32
+
+// Equal bytes needed to end a delta run, shorter gaps are copied as part of the run
+#define SNAPSHOT_DELTA_MIN_GAP	8
+
+// Contiguous copy of simulation state (see 'SnapshotHeader'),
+// or a delta between two such copies
+typedef struct {
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+
+} Snapshot;
+
+void SnapshotClose(Snapshot *snap);
+
+// Copy handler state into snapshot, reuses snapshot memory
+void SnapshotCapture(Snapshot *snap, Handler *handler);
+bool SnapshotRestore(Snapshot *snap, Handler *handler);
+
+// *
+// Deltas:
+// u32 target size, then runs of: u32 offset, u32 length, bytes[length]
+// *
+
+// Encode changes turning 'base' into 'target'
+void SnapshotDelta(Snapshot *base, Snapshot *target, Snapshot *delta);
+
+// Apply delta to snapshot in place
+bool SnapshotApplyDelta(Snapshot *snap, Snapshot *delta);
+
+bool SnapshotSaveFile(Snapshot *snap, char *path);
+bool SnapshotLoadFile(Snapshot *snap, char *path);
+
+// Rolling history of past states
+// Newest state is kept whole, older ones as deltas each turning the next newer state into itself,
+// so dropping the oldest entry never invalidates the others
+typedef struct {
+	Snapshot latest;
+	Snapshot scratch;
+
+	// Ring of backward deltas, 'head' is newest
+	Snapshot deltas[SNAPSHOT_HISTORY_CAP];
+
+	// Ticks between captures
+	uint32_t interval;
+
+	uint8_t head;
+	uint8_t count;
+
+	bool has_latest;
+
+} SnapshotHistory;
+
+void SnapshotHistoryInit(SnapshotHistory *history, uint32_t interval);
+void SnapshotHistoryClose(SnapshotHistory *history);
+
+// Forget all past states
+void SnapshotHistoryReset(SnapshotHistory *history);
+
+// Capture state if handler is on a capture tick
+void SnapshotHistoryUpdate(SnapshotHistory *history, Handler *handler);
+
+// Restore state from 'steps' captures back, later captures are discarded
+bool SnapshotHistoryRewind(SnapshotHistory *history, Handler *handler, uint8_t steps);
+
+#endif
@@ -0,0 +1,102 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "statics.h"
+#include "memory.h"
+
+void StaticLayerInit(StaticLayer *layer) {
+	*layer = (StaticLayer) { 0 };
+}
+
+void StaticLayerClose(StaticLayer *layer) {
+	TrackedFree(layer->memory);
+	*layer = (StaticLayer) { 0 };
+}
+
+void StaticLayerBake(StaticLayer *layer, const StaticDef *defs, uint32_t count, CellLayout layout) {
+	StaticLayerClose(layer);
+
+	uint32_t cell_count = layout.cols * layout.rows;
+
+	layer->layout = layout;
+
+	// One block: positions, radii, cell offsets, draw items
+	size_t floats_size = sizeof(float) * count;
+	size_t cells_size = sizeof(uint32_t) * (cell_count + 1);
+
+	uint8_t *memory = TrackedCalloc(1, floats_size * 3 + cells_size + sizeof(RenderStatic) * count);
+	layer->memory = memory;
+
+	layer->pos_x = (float*)memory;
+	layer->pos_y = (float*)(memory + floats_size);
+	layer->radius = (float*)(memory + floats_size * 2);
+	layer->cell_start = (uint32_t*)(memory + floats_size * 3);
+
+	RenderStatic *items = (RenderStatic*)(memory + floats_size * 3 + cells_size);
+
+	// Counting sort by cell: count, prefix sum, scatter
+	uint32_t dropped = 0;
+
+	for(uint32_t i = 0; i < count; i++) {
+		int32_t cell = CellOf(&layout, defs[i].position);
+
+		if(cell < 0) dropped++;
+		else layer->cell_start[cell + 1]++;
+	}
+
+	for(uint32_t c = 0; c < cell_count; c++) 
+		layer->cell_start[c + 1] += layer->cell_start[c];
+
+	uint32_t *next = TrackedMalloc(sizeof(uint32_t) * cell_count);
+	memcpy(next, layer->cell_start, sizeof(uint32_t) * cell_count);
+
+	for(uint32_t i = 0; i < count; i++) {
+		const StaticDef *def = &defs[i];
+
+		int32_t cell = CellOf(&layout, def->position);
+		if(cell < 0) continue;
+
+		uint32_t slot = next[cell]++;
+
+		layer->pos_x[slot] = def->position.x;
+		layer->pos_y[slot] = def->position.y;
+		layer->radius[slot] = def->radius;
+
+		items[slot] = (RenderStatic) {
+			.position = def->position,
+			.radius = def->radius,
+			.rotation = def->rotation,
+			.sprite_id = def->sprite_id
+		};
+
+		if(def->radius > layer->max_radius) layer->max_radius = def->radius;
+	}
+
+	TrackedFree(next);
+
+	layer->count = count - dropped;
+
+	layer->view = (RenderStaticLayer) {
+		.items = items,
+		.cell_start = layer->cell_start,
+		.layout = layout,
+		.max_radius = layer->max_radius,
+		.count = layer->count
+	};
+
+	if(dropped) printf("WARNING: %d static objects outside grid dropped\n", dropped);
+}
+
+bool StaticCellRange(StaticLayer *layer, Vector2 center, float radius, int16_t *col_start, int16_t *row_start, int16_t *col_end, int16_t *row_end) {
+	if(!layer->count) return false;
+
+	float reach = radius + layer->max_radius;
+	Rectangle rec = (Rectangle) { center.x - reach, center.y - reach, reach * 2, reach * 2 };
+
+	CellRange(&layer->layout, rec, col_start, row_start, col_end, row_end);
+
+	return true;
+}
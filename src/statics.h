@@ -0,0 +1,63 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "render.h"
+#include "vec.h"
+
+#ifndef STATICS_H_
+#define STATICS_H_
+
+// Static object as read from level file
+typedef struct {
+	Vector2 position;
+	float radius;
+	float rotation;
+
+	uint16_t sprite_id;
+
+} StaticDef;
+
+vec_declare(vec_static, StaticDef)
+
+// *
+// Static layer, scenery that never moves (asteroids, terrain):
+// baked once at level load into its own cell index and never touched again,
+// so it costs nothing in transform, grid or render capture passes.
+//
+// Objects are sorted by cell, objects in cell c are [cell_start[c], cell_start[c + 1]).
+// Each object is stored in the cell of its center only,
+// queries widen their range by 'max_radius' to catch objects reaching in from neighbours.
+//
+// Immutable after baking, the renderer reads 'view' from its own thread without locking.
+// *
+typedef struct {
+	float *pos_x;
+	float *pos_y;
+	float *radius;
+
+	uint32_t *cell_start;	// 'cell_count + 1' entries
+
+	uint32_t count;
+	float max_radius;
+
+	CellLayout layout;
+
+	// Draw data sorted the same way, shared with render states
+	RenderStaticLayer view;
+
+	// Single allocation backing all arrays
+	void *memory;
+
+} StaticLayer;
+
+void StaticLayerInit(StaticLayer *layer);
+void StaticLayerClose(StaticLayer *layer);
+
+// Replace layer contents, objects outside layout are dropped
+void StaticLayerBake(StaticLayer *layer, const StaticDef *defs, uint32_t count, CellLayout layout);
+
+// Cell range that may hold objects overlapping the circle, false if layer is empty
+bool StaticCellRange(StaticLayer *layer, Vector2 center, float radius, int16_t *col_start, int16_t *row_start, int16_t *col_end, int16_t *row_end);
+
+#endif
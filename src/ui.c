@@ -0,0 +1,408 @@
+#include <stdint.h>
+#include <string.h>
+#include "raylib.h"
+#include "rlgl.h"
+#include "ui.h"
+
+// Spacing between glyphs as fraction of font size, same as 'DrawText'
+#define UI_TEXT_SPACING	0.1f
+
+#define UI_BOX_SIZE		10
+#define UI_BOX_GAP		2
+
+#define UI_COLOR_PANEL		(Color) { 16, 18, 28, 220 }
+#define UI_COLOR_BORDER		(Color) { 90, 96, 120, 255 }
+#define UI_COLOR_BUTTON		(Color) { 40, 44, 60, 255 }
+#define UI_COLOR_HOT		(Color) { 64, 70, 96, 255 }
+#define UI_COLOR_ACTIVE		(Color) { 40, 110, 160, 255 }
+
+// FNV-1a
+static uint32_t UiHash(uint32_t hash, const void *data, size_t size) {
+	const uint8_t *bytes = data;
+
+	for(size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+void UiInit(Ui *ui) {
+	*ui = (Ui) { 0 };
+
+	// Default font atlas has a white rectangle raylib uses for shapes
+	ui->font = GetFontDefault();
+	ui->white = GetShapesTextureRectangle();
+
+	vec_uiquad_init(&ui->quads, UI_CMD_CAP);
+}
+
+void UiClose(Ui *ui) {
+	vec_uiquad_free(&ui->quads);
+}
+
+// Glyph offsets and width of string at font base size
+static void UiTextLayout(Ui *ui, UiText *text) {
+	Font *font = &ui->font;
+	float spacing = font->baseSize * UI_TEXT_SPACING;
+
+	float x = 0;
+	text->glyph_count = 0;
+
+	for(const char *c = text->str; *c; c++) {
+		int glyph = GetGlyphIndex(*font, (unsigned char)*c);
+
+		// Spaces only move the pen
+		if(*c != ' ' && *c != '\t')
+			text->glyphs[text->glyph_count++] = (UiGlyph) { .x = x, .glyph = glyph };
+
+		float advance = (font->glyphs[glyph].advanceX) ? font->glyphs[glyph].advanceX : font->recs[glyph].width;
+		x += advance + spacing;
+	}
+
+	text->width = (x > 0) ? x - spacing : 0;
+}
+
+// Cache slot for string, laid out on first use, -1 if every slot is in use this frame
+static int16_t UiTextGet(Ui *ui, const char *str) {
+	size_t length = 0;
+	while(length < UI_TEXT_MAX && str[length]) length++;
+
+	uint32_t hash = UiHash(2166136261u, str, length);
+	if(!hash) hash = 1;
+
+	int16_t free_slot = -1;
+	int16_t oldest = -1;
+
+	for(uint16_t i = 0; i < UI_TEXT_CACHE; i++) {
+		UiText *text = &ui->texts[i];
+
+		if(!text->hash) {
+			if(free_slot < 0) free_slot = i;
+			continue;
+		}
+
+		if(text->hash == hash && !strncmp(text->str, str, length) && !text->str[length]) {
+			text->last_used = ui->frame;
+			return i;
+		}
+
+		// Slots already referenced by this frame's commands stay
+		if(text->last_used != ui->frame && (oldest < 0 || text->last_used < ui->texts[oldest].last_used)) oldest = i;
+	}
+
+	int16_t slot = (free_slot >= 0) ? free_slot : oldest;
+	if(slot < 0) return -1;
+
+	UiText *text = &ui->texts[slot];
+
+	memcpy(text->str, str, length);
+	text->str[length] = '\0';
+	text->hash = hash;
+	text->last_used = ui->frame;
+
+	UiTextLayout(ui, text);
+
+	return slot;
+}
+
+static UiCmd *UiPush(Ui *ui, uint8_t type, Rectangle rec, Color color) {
+	if(ui->cmd_count >= UI_CMD_CAP) return NULL;
+
+	UiCmd *cmd = &ui->cmds[ui->cmd_count++];
+	*cmd = (UiCmd) { .rec = rec, .color = color, .type = type };
+
+	return cmd;
+}
+
+// Text at position, returns width in pixels
+static float UiPushText(Ui *ui, Vector2 position, const char *str, float size, Color color) {
+	int16_t index = UiTextGet(ui, str);
+	if(index < 0) return 0;
+
+	float width = ui->texts[index].width * size / ui->font.baseSize;
+
+	UiCmd *cmd = UiPush(ui, UI_CMD_TEXT, (Rectangle) { position.x, position.y, width, size }, color);
+
+	if(cmd) {
+		cmd->size = size;
+		cmd->text = index;
+	}
+
+	return width;
+}
+
+static float UiTextWidth(Ui *ui, const char *str, float size) {
+	int16_t index = UiTextGet(ui, str);
+	return (index < 0) ? 0 : ui->texts[index].width * size / ui->font.baseSize;
+}
+
+static void UiNewLine(UiLayout *layout) {
+	layout->cursor.x = layout->rec.x + UI_PADDING;
+	layout->cursor.y += layout->row_height + UI_PADDING / 2;
+	layout->row_height = 0;
+	layout->columns_left = 0;
+}
+
+// Space for next widget in current panel
+static Rectangle UiNext(Ui *ui, float height) {
+	UiLayout *layout = &ui->layout;
+
+	float width = (layout->columns_left) ? layout->column_width : layout->rec.width - UI_PADDING * 2;
+	Rectangle rec = (Rectangle) { layout->cursor.x, layout->cursor.y, width, height };
+
+	if(height > layout->row_height) layout->row_height = height;
+
+	if(layout->columns_left && --layout->columns_left)
+		layout->cursor.x += width + UI_PADDING;
+	else
+		UiNewLine(layout);
+
+	return rec;
+}
+
+void UiBegin(Ui *ui, Vector2 mouse, bool mouse_down) {
+	ui->frame++;
+	ui->cmd_count = 0;
+	ui->wants_mouse = (ui->active != 0);
+
+	ui->mouse_pressed = (mouse_down && !ui->mouse_down);
+	ui->mouse_released = (!mouse_down && ui->mouse_down);
+	ui->mouse_down = mouse_down;
+	ui->mouse = mouse;
+}
+
+// Quads for one command
+static void UiExpand(Ui *ui, UiCmd *cmd) {
+	Rectangle rec = cmd->rec;
+
+	switch(cmd->type) {
+		case UI_CMD_RECT:
+			vec_uiquad_push(&ui->quads, (UiQuad) { rec, ui->white, cmd->color });
+			break;
+
+		case UI_CMD_FRAME: {
+			Rectangle sides[4] = {
+				{ rec.x, rec.y, rec.width, 1 },
+				{ rec.x, rec.y + rec.height - 1, rec.width, 1 },
+				{ rec.x, rec.y + 1, 1, rec.height - 2 },
+				{ rec.x + rec.width - 1, rec.y + 1, 1, rec.height - 2 }
+			};
+
+			for(uint8_t i = 0; i < 4; i++)
+				vec_uiquad_push(&ui->quads, (UiQuad) { sides[i], ui->white, cmd->color });
+		} break;
+
+		case UI_CMD_TEXT: {
+			Font *font = &ui->font;
+			UiText *text = &ui->texts[cmd->text];
+
+			float scale = cmd->size / font->baseSize;
+			float pad = font->glyphPadding;
+
+			for(uint8_t i = 0; i < text->glyph_count; i++) {
+				UiGlyph *g = &text->glyphs[i];
+				Rectangle src = font->recs[g->glyph];
+				GlyphInfo *info = &font->glyphs[g->glyph];
+
+				Rectangle dest = (Rectangle) {
+					.x = rec.x + (g->x + info->offsetX - pad) * scale,
+					.y = rec.y + (info->offsetY - pad) * scale,
+					.width = (src.width + pad * 2) * scale,
+					.height = (src.height + pad * 2) * scale
+				};
+
+				src = (Rectangle) { src.x - pad, src.y - pad, src.width + pad * 2, src.height + pad * 2 };
+
+				vec_uiquad_push(&ui->quads, (UiQuad) { dest, src, cmd->color });
+			}
+		} break;
+
+		case UI_CMD_BOXES: {
+			uint16_t per_row = (rec.width + UI_BOX_GAP) / (UI_BOX_SIZE + UI_BOX_GAP);
+			if(!per_row) break;
+
+			for(uint16_t i = 0; i < cmd->count; i++) {
+				Rectangle box = (Rectangle) {
+					.x = rec.x + (i % per_row) * (UI_BOX_SIZE + UI_BOX_GAP),
+					.y = rec.y + (i / per_row) * (UI_BOX_SIZE + UI_BOX_GAP),
+					.width = UI_BOX_SIZE,
+					.height = UI_BOX_SIZE
+				};
+
+				vec_uiquad_push(&ui->quads, (UiQuad) { box, ui->white, cmd->color });
+			}
+		} break;
+	}
+}
+
+void UiEnd(Ui *ui) {
+	// Button is only held until release
+	if(ui->mouse_released) ui->active = 0;
+
+	// Text cache slots may move between frames, hash the strings themselves
+	uint32_t hash = 2166136261u;
+
+	for(uint16_t i = 0; i < ui->cmd_count; i++) {
+		UiCmd *cmd = &ui->cmds[i];
+
+		hash = UiHash(hash, &cmd->rec, sizeof(cmd->rec));
+		hash = UiHash(hash, &cmd->color, sizeof(cmd->color));
+		hash = UiHash(hash, &cmd->type, sizeof(cmd->type));
+		hash = UiHash(hash, &cmd->count, sizeof(cmd->count));
+
+		if(cmd->type == UI_CMD_TEXT) {
+			hash = UiHash(hash, &cmd->size, sizeof(cmd->size));
+			hash = UiHash(hash, &ui->texts[cmd->text].hash, sizeof(uint32_t));
+		}
+	}
+
+	// Same widgets in the same state as last frame, quads are still valid
+	if(hash == ui->hash) return;
+	ui->hash = hash;
+
+	vec_uiquad_clear(&ui->quads);
+
+	for(uint16_t i = 0; i < ui->cmd_count; i++)
+		UiExpand(ui, &ui->cmds[i]);
+}
+
+void UiDraw(Ui *ui) {
+	if(!ui->quads.count) return;
+
+	Texture2D texture = ui->font.texture;
+	float w = texture.width;
+	float h = texture.height;
+
+	// Single texture for everything, raylib only splits this if the vertex buffer fills up
+	rlSetTexture(texture.id);
+	rlBegin(RL_QUADS);
+	rlNormal3f(0.0f, 0.0f, 1.0f);
+
+	for(size_t i = 0; i < ui->quads.count; i++) {
+		UiQuad *q = &ui->quads.data[i];
+
+		rlColor4ub(q->color.r, q->color.g, q->color.b, q->color.a);
+
+		rlTexCoord2f(q->src.x / w, q->src.y / h);
+		rlVertex2f(q->dest.x, q->dest.y);
+
+		rlTexCoord2f(q->src.x / w, (q->src.y + q->src.height) / h);
+		rlVertex2f(q->dest.x, q->dest.y + q->dest.height);
+
+		rlTexCoord2f((q->src.x + q->src.width) / w, (q->src.y + q->src.height) / h);
+		rlVertex2f(q->dest.x + q->dest.width, q->dest.y + q->dest.height);
+
+		rlTexCoord2f((q->src.x + q->src.width) / w, q->src.y / h);
+		rlVertex2f(q->dest.x + q->dest.width, q->dest.y);
+	}
+
+	rlEnd();
+	rlSetTexture(0);
+}
+
+bool UiWantsMouse(Ui *ui) {
+	return ui->wants_mouse;
+}
+
+void UiPanelBegin(Ui *ui, Rectangle rec, const char *title) {
+	if(CheckCollisionPointRec(ui->mouse, rec)) ui->wants_mouse = true;
+
+	ui->layout = (UiLayout) {
+		.rec = rec,
+		.cursor = (Vector2) { rec.x + UI_PADDING, rec.y + UI_PADDING },
+		.panel_cmd = ui->cmd_count
+	};
+
+	UiPush(ui, UI_CMD_RECT, rec, UI_COLOR_PANEL);
+	UiPush(ui, UI_CMD_FRAME, rec, UI_COLOR_BORDER);
+
+	if(title) {
+		Rectangle row = UiNext(ui, UI_ROW_HEIGHT);
+		UiPushText(ui, (Vector2) { row.x, row.y + UI_PADDING / 2 }, title, UI_FONT_SIZE, GOLD);
+	}
+}
+
+void UiPanelEnd(Ui *ui) {
+	UiLayout *layout = &ui->layout;
+
+	if(layout->columns_left) UiNewLine(layout);
+
+	// Fit to content
+	if(layout->rec.height <= 0 && layout->panel_cmd + 1 < ui->cmd_count) {
+		float height = layout->cursor.y - layout->rec.y + UI_PADDING / 2;
+
+		ui->cmds[layout->panel_cmd].rec.height = height;
+		ui->cmds[layout->panel_cmd + 1].rec.height = height;
+
+		layout->rec.height = height;
+		if(CheckCollisionPointRec(ui->mouse, layout->rec)) ui->wants_mouse = true;
+	}
+}
+
+void UiRow(Ui *ui, uint8_t columns) {
+	UiLayout *layout = &ui->layout;
+
+	if(layout->columns_left) UiNewLine(layout);
+	if(columns < 2) return;
+
+	layout->columns_left = columns;
+	layout->column_width = (layout->rec.width - UI_PADDING * (columns + 1)) / columns;
+}
+
+void UiLabel(Ui *ui, const char *text) {
+	Rectangle row = UiNext(ui, UI_ROW_HEIGHT);
+	UiPushText(ui, (Vector2) { row.x, row.y + UI_PADDING / 2 }, text, UI_FONT_SIZE, LIGHTGRAY);
+}
+
+void UiCounter(Ui *ui, const char *text, int value) {
+	Rectangle row = UiNext(ui, UI_ROW_HEIGHT);
+	float y = row.y + UI_PADDING / 2;
+
+	UiPushText(ui, (Vector2) { row.x, y }, text, UI_FONT_SIZE, LIGHTGRAY);
+
+	const char *number = TextFormat("%d", value);
+	float width = UiTextWidth(ui, number, UI_FONT_SIZE);
+
+	UiPushText(ui, (Vector2) { row.x + row.width - width, y }, number, UI_FONT_SIZE, RAYWHITE);
+}
+
+bool UiButton(Ui *ui, const char *text) {
+	Rectangle rec = UiNext(ui, UI_ROW_HEIGHT);
+
+	// Label and place identify a button, no state is kept for it
+	uint32_t id = UiHash(UiHash(2166136261u, text, strlen(text)), &rec, sizeof(Vector2));
+
+	bool hot = CheckCollisionPointRec(ui->mouse, rec);
+	bool clicked = false;
+
+	if(hot && ui->mouse_pressed) ui->active = id;
+	if(ui->active == id && ui->mouse_released && hot) clicked = true;
+
+	Color color = UI_COLOR_BUTTON;
+	if(ui->active == id) color = UI_COLOR_ACTIVE;
+	else if(hot) color = UI_COLOR_HOT;
+
+	UiPush(ui, UI_CMD_RECT, rec, color);
+	UiPush(ui, UI_CMD_FRAME, rec, UI_COLOR_BORDER);
+
+	float width = UiTextWidth(ui, text, UI_FONT_SIZE);
+	UiPushText(ui, (Vector2) { rec.x + (rec.width - width) * 0.5f, rec.y + UI_PADDING / 2 }, text, UI_FONT_SIZE, RAYWHITE);
+
+	return clicked;
+}
+
+void UiBoxes(Ui *ui, uint32_t count, uint8_t rows, Color color) {
+	float width = ui->layout.rec.width - UI_PADDING * 2;
+	uint32_t per_row = (width + UI_BOX_GAP) / (UI_BOX_SIZE + UI_BOX_GAP);
+
+	if(count > per_row * rows) count = per_row * rows;
+	if(!count) return;
+
+	uint32_t used_rows = (count + per_row - 1) / per_row;
+	Rectangle rec = UiNext(ui, used_rows * (UI_BOX_SIZE + UI_BOX_GAP) - UI_BOX_GAP);
+
+	UiCmd *cmd = UiPush(ui, UI_CMD_BOXES, rec, color);
+	if(cmd) cmd->count = count;
+}
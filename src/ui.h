@@ -0,0 +1,173 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "vec.h"
+
+#ifndef UI_H_
+#define UI_H_
+
+// Window pixels
+#define UI_FONT_SIZE	20
+#define UI_PADDING		8
+#define UI_ROW_HEIGHT	(UI_FONT_SIZE + UI_PADDING)
+
+// Panel holding 'rows' labels, counters or buttons, title counts as one
+#define UI_PANEL_HEIGHT(rows)	(UI_PADDING + (rows) * (UI_ROW_HEIGHT + UI_PADDING / 2) + UI_PADDING / 2)
+
+// Text layouts kept between frames, least recently used is replaced
+#define UI_TEXT_CACHE	128
+
+// Longer strings are cut
+#define UI_TEXT_MAX		48
+
+// Widgets per frame, more are dropped
+#define UI_CMD_CAP		256
+
+enum UI_CMD_TYPES {
+	UI_CMD_RECT,
+	UI_CMD_FRAME,	// Outline of 'rec'
+	UI_CMD_TEXT,
+	UI_CMD_BOXES	// 'count' small squares flowing across 'rec'
+};
+
+// Glyph position in a laid out string, at font base size
+typedef struct {
+	float x;
+	uint16_t glyph;
+
+} UiGlyph;
+
+// Measured string, reused while the same text is drawn
+typedef struct {
+	uint32_t hash;		// 0 if slot is free
+	uint32_t last_used;
+
+	float width;		// At font base size
+
+	char str[UI_TEXT_MAX + 1];
+
+	uint8_t glyph_count;
+	UiGlyph glyphs[UI_TEXT_MAX];
+
+} UiText;
+
+// What a widget asked for, expanded into quads at the end of the frame
+typedef struct {
+	Rectangle rec;
+	Color color;
+
+	float size;			// Text only
+	uint8_t text;		// Index into text cache
+
+	uint16_t count;		// Boxes only
+
+	uint8_t type;
+
+} UiCmd;
+
+// One textured quad, everything samples the font atlas
+typedef struct {
+	Rectangle dest;
+	Rectangle src;
+	Color color;
+
+} UiQuad;
+
+vec_declare(vec_uiquad, UiQuad)
+
+// Vertical layout inside current panel
+typedef struct {
+	Rectangle rec;
+	Vector2 cursor;
+
+	// Tallest widget in current row
+	float row_height;
+
+	// Widgets left in current row, width of each
+	uint8_t columns_left;
+	float column_width;
+
+	// Background command, sized to content at 'UiPanelEnd' if panel height is 0
+	uint16_t panel_cmd;
+
+} UiLayout;
+
+// *
+// Immediate mode UI
+//
+// Widgets are plain calls made every frame between 'UiBegin' and 'UiEnd',
+// nothing is kept per widget except the text layout cache.
+// Each call records a small command, at the end of the frame commands are hashed
+// and only expanded into quads (text into glyphs) when the hash differs from last frame.
+// Shapes use the white pixel of the default font atlas,
+// so the whole UI is one texture and a single batch.
+// *
+typedef struct {
+	Font font;
+	Rectangle white;
+
+	UiText texts[UI_TEXT_CACHE];
+
+	UiCmd cmds[UI_CMD_CAP];
+	uint16_t cmd_count;
+
+	// Quads of last expanded frame, kept while nothing changes
+	vec_uiquad quads;
+
+	// Hash of the commands 'quads' were built from
+	uint32_t hash;
+
+	UiLayout layout;
+
+	// Mouse in window pixels
+	Vector2 mouse;
+	bool mouse_down;
+	bool mouse_pressed;
+	bool mouse_released;
+
+	// Button being held, 0 if none
+	uint32_t active;
+
+	// Mouse is over a panel, or a button is held
+	bool wants_mouse;
+
+	uint32_t frame;
+
+} Ui;
+
+// Needs graphics context
+void UiInit(Ui *ui);
+void UiClose(Ui *ui);
+
+// Start recording widgets, mouse in window pixels
+void UiBegin(Ui *ui, Vector2 mouse, bool mouse_down);
+
+// Rebuild quads if anything changed since last frame
+void UiEnd(Ui *ui);
+
+// Everything recorded, in one batch, call in window space
+void UiDraw(Ui *ui);
+
+// Clicks belong to the UI this frame
+bool UiWantsMouse(Ui *ui);
+
+// Background with a title row, widgets are stacked top to bottom until 'UiPanelEnd'
+// Height 0 fits the panel to its widgets
+void UiPanelBegin(Ui *ui, Rectangle rec, const char *title);
+void UiPanelEnd(Ui *ui);
+
+// Split next 'columns' widgets evenly across one row
+void UiRow(Ui *ui, uint8_t columns);
+
+void UiLabel(Ui *ui, const char *text);
+
+// Text on the left, value on the right
+void UiCounter(Ui *ui, const char *text, int value);
+
+// True on release over the button it was pressed on
+bool UiButton(Ui *ui, const char *text);
+
+// Flow of small boxes, one per item, cut at whatever fits in 'rows' rows
+void UiBoxes(Ui *ui, uint32_t count, uint8_t rows, Color color);
+
+#endif
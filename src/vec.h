@@ -3,37 +3,144 @@
 
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
+#include "memory.h"
 
-#define vec_define(_name, _type)																			\
+// Smallest capacity a vector grows to
+#define VEC_MIN_CAPACITY 8
+
+// *
+// Typed dynamic arrays
+//
+// eg.
+// vec_declare(vec_ent, INT_N)
+// defines type 'vec_ent' and functions 'vec_ent_init()', 'vec_ent_push()', etc.
+//
+// Storage is one of:
+// - heap, 'init()' then 'free()' when done
+// - arena, 'init_arena()', memory released with the arena, 'free()' not needed
+// - inline, 'vec_declare_inline()' keeps the first N elements inside the struct,
+//   spills to heap (or arena) past that.
+//   Inline vectors point into themselves, don't copy them by value after 'init()'
+// *
+
+#define vec_define(_name, _type, _inline)																	\
 typedef struct {																							\
 	_type *data;																							\
+	_type *inline_data;																						\
+	Arena *arena;																							\
 	size_t count;																							\
 	size_t capacity;																						\
+	_inline																									\
 } _name;
 
-#define vec_declare(_name, _type)																			\
+#define vec_functions(_name, _type, _inline_data, _inline_cap)												\
+																											\
+	static inline void _name##_init_arena(_name *v, Arena *arena, size_t capacity);							\
+																											\
+	static inline void _name##_init(_name *v, size_t capacity) {											\
+		_name##_init_arena(v, NULL, capacity);																\
+	}																										\
+																											\
+	static inline void _name##_free(_name *v) {																\
+		if(!v->arena && v->data != v->inline_data) TrackedFree(v->data);									\
+																											\
+		v->data = v->inline_data;																			\
+		v->count = 0;																						\
+		v->capacity = (_inline_cap);																		\
+	}																										\
 																											\
-	vec_define(_name, _type)																				\
-	_name _v_##_name = (_name) {																			\
-		.data = NULL,																						\
-		.count = 0,																							\
-		.capacity = 0,																						\
-	};																										\
-																											\
-	void _v_##_name##_push (_type thing) {																	\
-		if(_v_##_name.count + 1 > _v_##_name.capacity) {													\
-			_v_##_name.capacity *= 2;																		\
-																											\
-			if(_v_##_name.capacity > 0)	{																	\
-				_type *ptr = realloc(_v_##_name.data, sizeof(_type) * _v_##_name.capacity);					\
-				_v_##_name.data = ptr;																		\
-			} else {																						\
-				_v_##_name.capacity = 1;																	\
-				_v_##_name.data = malloc(sizeof(_type) * _v_##_name.capacity);								\
-			}																								\
+	static inline void _name##_reserve(_name *v, size_t capacity) {										\
+		if(capacity <= v->capacity) return;																	\
+																											\
+		_type *ptr;																							\
+		if(v->arena) {																						\
+			ptr = ArenaAlloc(v->arena, sizeof(_type) * capacity);											\
+			if(v->count) memcpy(ptr, v->data, sizeof(_type) * v->count);									\
+		} else if(v->data == v->inline_data) {																\
+			ptr = TrackedMalloc(sizeof(_type) * capacity);													\
+			if(v->count) memcpy(ptr, v->data, sizeof(_type) * v->count);									\
+		} else {																							\
+			ptr = TrackedRealloc(v->data, sizeof(_type) * capacity);										\
 		}																									\
 																											\
-		_v_##_name.data[_v_##_name.count++] = thing;														\
+		v->data = ptr;																						\
+		v->capacity = capacity;																				\
+	}																										\
+																											\
+	static inline void _name##_init_arena(_name *v, Arena *arena, size_t capacity) {						\
+		v->inline_data = (_inline_data);																	\
+		v->data = v->inline_data;																			\
+		v->arena = arena;																					\
+		v->count = 0;																						\
+		v->capacity = (_inline_cap);																		\
+																											\
+		_name##_reserve(v, capacity);																		\
+	}																										\
+																											\
+	/* Grow geometrically so repeated pushes stay amortized O(1) */											\
+	static inline void _name##_grow(_name *v, size_t min_capacity) {										\
+		if(min_capacity <= v->capacity) return;																\
+																											\
+		size_t capacity = (v->capacity > VEC_MIN_CAPACITY) ? v->capacity : VEC_MIN_CAPACITY;				\
+		while(capacity < min_capacity) capacity *= 2;														\
+																											\
+		_name##_reserve(v, capacity);																		\
+	}																										\
+																											\
+	static inline size_t _name##_push(_name *v, _type thing) {												\
+		if(v->count + 1 > v->capacity) _name##_grow(v, v->count + 1);										\
+																											\
+		v->data[v->count] = thing;																			\
+		return v->count++;																					\
+	}																										\
+																											\
+	/* Copy 'n' elements to the end in one go */															\
+	static inline void _name##_append(_name *v, const _type *things, size_t n) {							\
+		if(!n) return;																						\
+		if(v->count + n > v->capacity) _name##_grow(v, v->count + n);										\
+																											\
+		memcpy(&v->data[v->count], things, sizeof(_type) * n);												\
+		v->count += n;																						\
+	}																										\
+																											\
+	static inline _type _name##_pop(_name *v) {																\
+		return v->data[--v->count];																			\
+	}																										\
+																											\
+	/* Insert at index, shifting later elements up */														\
+	static inline void _name##_insert(_name *v, size_t i, _type thing) {									\
+		if(v->count + 1 > v->capacity) _name##_grow(v, v->count + 1);										\
+																											\
+		memmove(&v->data[i + 1], &v->data[i], sizeof(_type) * (v->count - i));								\
+		v->data[i] = thing;																					\
+		v->count++;																							\
+	}																										\
+																											\
+	/* Remove at index keeping order, O(n) */																\
+	static inline void _name##_remove(_name *v, size_t i) {												\
+		memmove(&v->data[i], &v->data[i + 1], sizeof(_type) * (v->count - i - 1));							\
+		v->count--;																							\
+	}																										\
+																											\
+	/* Remove at index by moving last element into it, O(1) */												\
+	static inline void _name##_swap_remove(_name *v, size_t i) {											\
+		v->data[i] = v->data[--v->count];																	\
+	}																										\
+																											\
+	/* Drop all elements, keep memory */																	\
+	static inline void _name##_clear(_name *v) {															\
+		v->count = 0;																						\
 	}
 
+// Heap or arena backed vector
+#define vec_declare(_name, _type)																			\
+	vec_define(_name, _type, )																				\
+	vec_functions(_name, _type, NULL, 0)
+
+// Vector storing up to '_n' elements inline before touching the heap
+#define vec_declare_inline(_name, _type, _n)																\
+	vec_define(_name, _type, _type small[_n];)																\
+	vec_functions(_name, _type, v->small, _n)
+
 #endif
@@ -0,0 +1,106 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "raylib.h"
+#include "visibility.h"
+#include "memory.h"
+
+// Cells within radius r of the center, padded by half a cell so circles look round
+static bool InCircle(int32_t dc, int32_t dr, uint8_t r) {
+	return (dc * dc + dr * dr) <= (r + 0.5f) * (r + 0.5f);
+}
+
+void VisibilityInit(Visibility *vis, CellLayout layout) {
+	uint32_t cell_count = layout.cols * layout.rows;
+
+	// Count mask cells for every radius
+	uint32_t offset_count = 0;
+
+	for(uint8_t r = 0; r <= VISION_MAX_CELLS; r++) {
+		for(int32_t dr = -r; dr <= r; dr++) {
+			for(int32_t dc = -r; dc <= r; dc++) 
+				offset_count += InCircle(dc, dr, r);
+		}
+	}
+
+	// Counts first, largest alignment
+	size_t size = (sizeof(uint16_t) + sizeof(uint8_t)) * cell_count + sizeof(VisionOffset) * offset_count;
+	uint8_t *memory = TrackedCalloc(1, size);
+
+	*vis = (Visibility) {
+		.counts = (uint16_t*)memory,
+		.explored = memory + sizeof(uint16_t) * cell_count,
+		.offsets = (VisionOffset*)(memory + (sizeof(uint16_t) + sizeof(uint8_t)) * cell_count),
+		.layout = layout,
+		.cell_count = cell_count,
+		.memory = memory
+	};
+
+	// Fill masks
+	uint32_t n = 0;
+
+	for(uint8_t r = 0; r <= VISION_MAX_CELLS; r++) {
+		vis->mask_start[r] = n;
+
+		for(int32_t dr = -r; dr <= r; dr++) {
+			for(int32_t dc = -r; dc <= r; dc++) {
+				if(InCircle(dc, dr, r)) vis->offsets[n++] = (VisionOffset) { dc, dr };
+			}
+		}
+	}
+
+	vis->mask_start[VISION_MAX_CELLS + 1] = n;
+}
+
+void VisibilityClose(Visibility *vis) {
+	TrackedFree(vis->memory);
+	*vis = (Visibility) { 0 };
+}
+
+void VisibilityClear(Visibility *vis) {
+	memset(vis->counts, 0, sizeof(uint16_t) * vis->cell_count);
+	memset(vis->explored, 0, vis->cell_count);
+}
+
+void VisibilityStamp(Visibility *vis, int32_t cell, uint8_t radius, int8_t delta) {
+	if(cell < 0 || (uint32_t)cell >= vis->cell_count) return;
+	if(radius > VISION_MAX_CELLS) radius = VISION_MAX_CELLS;
+
+	int32_t col = cell % vis->layout.cols;
+	int32_t row = cell / vis->layout.cols;
+
+	for(uint32_t i = vis->mask_start[radius]; i < vis->mask_start[radius + 1]; i++) {
+		int32_t c = col + vis->offsets[i].dc;
+		int32_t r = row + vis->offsets[i].dr;
+
+		if(!CellInLayout(&vis->layout, c, r)) continue;
+
+		uint32_t id = c + r * vis->layout.cols;
+
+		vis->counts[id] += delta;
+		vis->explored[id] = 1;
+	}
+}
+
+int32_t VisibilityCell(Visibility *vis, Vector2 position) {
+	return CellOf(&vis->layout, position);
+}
+
+uint8_t VisibilityRadiusCells(Visibility *vis, float radius) {
+	float cells = ceilf(radius / vis->layout.cell_size.x);
+	return (cells < VISION_MAX_CELLS) ? (uint8_t)cells : VISION_MAX_CELLS;
+}
+
+bool VisibilityCellVisible(Visibility *vis, int32_t cell) {
+	return cell >= 0 && (uint32_t)cell < vis->cell_count && vis->counts[cell] > 0;
+}
+
+bool VisibilityAt(Visibility *vis, Vector2 position) {
+	return VisibilityCellVisible(vis, VisibilityCell(vis, position));
+}
+
+uint8_t VisibilityCellState(Visibility *vis, int32_t cell) {
+	if(vis->counts[cell]) return VISION_VISIBLE;
+
+	return (vis->explored[cell]) ? VISION_EXPLORED : VISION_HIDDEN;
+}
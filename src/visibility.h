@@ -0,0 +1,79 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "cells.h"
+
+#ifndef VISIBILITY_H_
+#define VISIBILITY_H_
+
+// Team fog of war is computed for, other teams see everything
+#define VISION_TEAM			0
+
+// Largest vision radius in cells, masks are precomputed up to this
+#define VISION_MAX_CELLS	8
+
+// Cell fog states, as copied into render states
+enum VISION_STATES {
+	VISION_HIDDEN,		// Never seen
+	VISION_EXPLORED,	// Seen before, nothing currently sees it
+	VISION_VISIBLE
+};
+
+typedef struct {
+	int8_t dc;
+	int8_t dr;
+
+} VisionOffset;
+
+// *
+// Fog of war, laid out over the level like the spatial grid
+//
+// Each vision source stamps a precomputed circle of cells around the cell it's in,
+// cells count the sources seeing them. Sources only restamp when they change cell:
+// the old circle is decremented and the new one incremented, so a tick costs
+// nothing for units that stay inside their cell.
+//
+// Counts are derived from vision components ('comp_Vision.cell'),
+// snapshots don't store them and rebuild after loading.
+// *
+typedef struct {
+	// Sources seeing each cell
+	uint16_t *counts;
+
+	// Cells seen at least once
+	uint8_t *explored;
+
+	// Circle of radius r is offsets[mask_start[r] .. mask_start[r + 1]]
+	VisionOffset *offsets;
+	uint32_t mask_start[VISION_MAX_CELLS + 2];
+
+	CellLayout layout;
+	uint32_t cell_count;
+
+	// Single allocation backing all arrays
+	void *memory;
+
+} Visibility;
+
+void VisibilityInit(Visibility *vis, CellLayout layout);
+void VisibilityClose(Visibility *vis);
+
+// Forget all sources and explored cells
+void VisibilityClear(Visibility *vis);
+
+// Add (delta 1) or remove (delta -1) a source's circle
+void VisibilityStamp(Visibility *vis, int32_t cell, uint8_t radius, int8_t delta);
+
+// Cell id of position, -1 outside layout
+int32_t VisibilityCell(Visibility *vis, Vector2 position);
+
+// Vision radius in whole cells, clamped to 'VISION_MAX_CELLS'
+uint8_t VisibilityRadiusCells(Visibility *vis, float radius);
+
+bool VisibilityCellVisible(Visibility *vis, int32_t cell);
+bool VisibilityAt(Visibility *vis, Vector2 position);
+
+// 'VISION_STATES' of cell
+uint8_t VisibilityCellState(Visibility *vis, int32_t cell);
+
+#endif
@@ -0,0 +1,92 @@
+#include <stdint.h>
+#include <math.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "waves.h"
+#include "handler.h"
+#include "prefabs.h"
+#include "kmath.h"
+#include "memory.h"
+
+void WavesInit(Waves *waves) {
+	vec_wave_init(&waves->defs, 0);
+	WavesReset(waves);
+}
+
+void WavesClose(Waves *waves) {
+	vec_wave_free(&waves->defs);
+}
+
+void WavesReset(Waves *waves) {
+	waves->timer = (waves->defs.count) ? waves->defs.data[0].delay : 0;
+	waves->current = 0;
+	waves->spawned = 0;
+	waves->count = 0;
+}
+
+// Random point in disc around center
+static Vector2 SpawnPoint(Rng *rng, Vector2 center, float radius) {
+	float angle = RngRange(rng, 0, 2 * PI);
+	float dist = sqrtf(RngFloat(rng)) * radius;
+
+	return Vector2Add(center, (Vector2) { cosf(angle) * dist, sinf(angle) * dist });
+}
+
+void WavesUpdate(Handler *handler, float dt) {
+	Waves *waves = &handler->waves;
+
+	if(waves->current >= waves->defs.count) return;
+
+	waves->timer -= dt;
+	if(waves->timer > 0) return;
+
+	WaveDef *wave = &waves->defs.data[waves->current];
+	Prefab *prefab = &prefabs[wave->prefab];
+
+	// Wave start, clamp to what pools can hold so spawning never fails halfway
+	if(waves->spawned == 0) {
+		INT_N capacity = HandlerSpawnCapacity(handler, prefab->components);
+		waves->count = (wave->count < capacity) ? wave->count : capacity;
+	}
+
+	// Units due this tick
+	uint16_t left = waves->count - waves->spawned;
+	uint16_t due = (wave->interval > 0) ? 1 : left;
+	if(due > WAVE_SPAWN_BUDGET) due = WAVE_SPAWN_BUDGET;
+
+	// Spawn all due units in one batch
+	ArenaMark mark = ArenaGetMark(handler->arena);
+	Vector2 *positions = ArenaAlloc(handler->arena, sizeof(Vector2) * due);
+	INT_N *ids = ArenaAlloc(handler->arena, sizeof(INT_N) * due);
+
+	for(uint16_t i = 0; i < due; i++) 
+		positions[i] = SpawnPoint(&handler->rng, wave->spawn, wave->spread);
+
+	INT_N spawned = SpawnBatch(handler, prefab, due, positions, ids);
+
+	if(prefab->components & COMP_ORDERS) {
+		for(INT_N i = 0; i < spawned; i++) {
+			Entity *entity = &handler->entities[ids[i]];
+
+			OrdersPush(handler, entity->comp_map.component_id[comp_index(COMP_ORDERS)], (Order) {
+				.target = wave->target,
+				.type = ORDER_ATTACK_MOVE
+			});
+		}
+	}
+
+	ArenaRewind(handler->arena, mark);
+
+	waves->spawned += due;
+	waves->timer = wave->interval;
+
+	if(waves->spawned < waves->count) return;
+
+	// Wave done, wait for next one
+	waves->current++;
+	waves->spawned = 0;
+	waves->count = 0;
+
+	if(waves->current < waves->defs.count)
+		waves->timer = waves->defs.data[waves->current].delay;
+}
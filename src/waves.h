@@ -0,0 +1,46 @@
+#include <stdint.h>
+#include "raylib.h"
+#include "vec.h"
+
+#ifndef WAVES_H_
+#define WAVES_H_
+
+// Most units created per tick, larger waves are spread over several ticks
+#define WAVE_SPAWN_BUDGET	128
+
+// Enemy wave, read from level file
+typedef struct {
+	uint16_t prefab;	// Index into prefab table
+	uint16_t count;
+
+	float interval;		// Seconds between units, 0 spawns whole wave at once
+	float delay;		// Seconds after previous wave finished spawning
+
+	Vector2 spawn;		// Spawn area center
+	float spread;		// Spawn area radius
+
+	Vector2 target;		// Where units attack-move to
+
+} WaveDef;
+
+vec_declare(vec_wave, WaveDef)
+
+typedef struct {
+	// Level data, not part of simulation state
+	vec_wave defs;
+
+	// Progress, saved in snapshots
+	float timer;		// Seconds until next spawn
+	uint16_t current;	// Wave being spawned
+	uint16_t spawned;	// Units of current wave spawned so far
+	uint16_t count;		// Units current wave will spawn, clamped to free capacity
+
+} Waves;
+
+void WavesInit(Waves *waves);
+void WavesClose(Waves *waves);
+
+// Restart from first wave
+void WavesReset(Waves *waves);
+
+#endif